@@ -0,0 +1,389 @@
+// ******************** FlopCpp **********************************************
+// File: generationBench.cpp
+// $Id$
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+//****************************************************************************
+
+// Measures model generation on synthetic models of several sizes.  Every
+// model and size is run in a process of its own, so that its peak memory
+// is its own, and gives one line of comma separated values:
+//
+//   model,size,rows,columns,nonzeros,attach_seconds,attach_cpu_seconds,
+//   nonzeros_per_second,peak_kb,solve_seconds,status
+//
+// Usage: generationBench [-o file] [-scale k] [-nosolve] [model ...]
+//   -o file   writes the values to file instead of generationBench.csv
+//   -scale k  multiplies every size by k
+//   -nosolve  only attaches the models, solve_seconds is then 0
+//   model     runs only the models named
+//
+// Built and run from the configured examples directory with
+//   make bench BENCHFLAGS="..."
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <CoinTime.hpp>
+#include <OsiCbcSolverInterface.hpp>
+#include "flopc.hpp"
+
+#ifndef _MSC_VER
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace flopc;
+using namespace std;
+
+namespace {
+    /// the same pseudo random numbers in [0,1) on every platform.
+    class Random {
+    public:
+	Random(unsigned long seed) : state(seed) {}
+	double operator()() {
+	    state = (state*1103515245UL+12345UL) & 0x7fffffffUL;
+	    return state/2147483648.0;
+	}
+	int operator()(int n) {
+	    return static_cast<int>((*this)()*n);
+	}
+    private:
+	unsigned long state;
+    };
+
+    struct Result {
+	Result() : rows(0), columns(0), nonzeros(0), attachWall(0.0),
+		   attachCpu(0.0), solveWall(0.0), status("not solved") {}
+	int rows;
+	int columns;
+	int nonzeros;
+	double attachWall;
+	double attachCpu;
+	double solveWall;
+	string status;
+    };
+
+    bool solving = true;
+
+    /// attaches the model defined in M, and solves it unless -nosolve.
+    void measure(MP_model& M, Result& r) {
+	double wall = CoinWallclockTime();
+	double cpu = CoinCpuTime();
+	M.attach(M.Solver);
+	r.attachWall = CoinWallclockTime()-wall;
+	r.attachCpu = CoinCpuTime()-cpu;
+	r.rows = M.Solver->getNumRows();
+	r.columns = M.Solver->getNumCols();
+	r.nonzeros = M.Solver->getNumElements();
+	if (solving == true) {
+	    wall = CoinWallclockTime();
+	    MP_model::MP_status s = M.solve(MP_model::MINIMIZE);
+	    r.solveWall = CoinWallclockTime()-wall;
+	    r.status = (s == MP_model::OPTIMAL) ? "optimal" : "not optimal";
+	}
+    }
+
+    /** Transportation problem with every supply connected to every
+        demand.  n supplies and n demands.
+    */
+    void transportDense(MP_model& M, int n, Result& r) {
+	Random random(1);
+	MP_set S(n), D(n);
+	MP_index i, j;
+	MP_data supply(S), demand(D), cost(S,D);
+	for (int a=0; a<n; a++) {
+	    supply(a) = 15;
+	    demand(a) = 5+10*random();
+	    for (int b=0; b<n; b++) {
+		cost(a,b) = 1+99*random();
+	    }
+	}
+	MP_variable x(S,D);
+	MP_constraint sup(S), dem(D);
+	sup(i) = sum(D(j), x(i,j)) <= supply(i);
+	dem(j) = sum(S(i), x(i,j)) >= demand(j);
+	M.setObjective(sum(S(i)*D(j), cost(i,j)*x(i,j)));
+	measure(M,r);
+    }
+
+    /** Transportation problem where every supply is connected to 8
+        demands, through an MP_subset of the links.  n supplies and n
+        demands.
+    */
+    void transportSparse(MP_model& M, int n, Result& r) {
+	Random random(2);
+	const int degree = n < 8 ? n : 8;
+	MP_set S(n), D(n);
+	MP_subset<2> Links(S,D);
+	MP_index i, j;
+	// Every demand gets as many links as every supply, which makes the
+	// problem feasible.
+	vector<int> shift(degree);
+	for (int t=0; t<degree; t++) {
+	    shift[t] = t*(n/degree);
+	}
+	for (int a=0; a<n; a++) {
+	    for (int t=0; t<degree; t++) {
+		Links.insert(a,(a+shift[t])%n);
+	    }
+	}
+	MP_data supply(S), demand(D), cost(Links);
+	for (int a=0; a<n; a++) {
+	    supply(a) = 15;
+	    demand(a) = 5+10*random();
+	}
+	for (int l=0; l<Links.size(); l++) {
+	    cost(l) = 1+99*random();
+	}
+	MP_variable x(Links);
+	MP_constraint sup(S), dem(D);
+	sup(i) = sum(Links(i,j), x(Links(i,j))) <= supply(i);
+	dem(j) = sum(Links(i,j), x(Links(i,j))) >= demand(j);
+	M.setObjective(sum(Links(i,j), cost(Links(i,j))*x(Links(i,j))));
+	measure(M,r);
+    }
+
+    /** Multi-commodity flow over a complete graph of n nodes, with n/4
+        commodities, each shipping from a node of its own to all others.
+        The flows have 3 indices: commodity, from and to.
+    */
+    void multiCommodity3(MP_model& M, int n, Result& r) {
+	Random random(3);
+	MP_set N(n), K(n/4 < 1 ? 1 : n/4);
+	MP_index k, i, j;
+	MP_data cost(N,N), b(K,N);
+	for (int a=0; a<n; a++) {
+	    for (int c=0; c<n; c++) {
+		cost(a,c) = 1+99*random();
+	    }
+	    for (int c=0; c<K.size(); c++) {
+		b(c,a) = (a == c) ? n-1 : -1;
+	    }
+	}
+	MP_variable f(K,N,N);
+	MP_constraint bal(K,N), cap(N,N);
+	bal(k,i) = sum(N(j), f(k,i,j)) - sum(N(j), f(k,j,i)) == b(k,i);
+	cap(i,j) = sum(K(k), f(k,i,j)) <= n;
+	M.setObjective(sum(K(k)*N(i)*N(j), cost(i,j)*f(k,i,j)));
+	measure(M,r);
+    }
+
+    /// As multiCommodity3(), over 4 periods: flows with 4 indices.
+    void multiCommodity4(MP_model& M, int n, Result& r) {
+	Random random(4);
+	MP_set N(n), K(n/4 < 1 ? 1 : n/4), T(4);
+	MP_index k, i, j, t;
+	MP_data cost(N,N), b(K,N);
+	for (int a=0; a<n; a++) {
+	    for (int c=0; c<n; c++) {
+		cost(a,c) = 1+99*random();
+	    }
+	    for (int c=0; c<K.size(); c++) {
+		b(c,a) = (a == c) ? n-1 : -1;
+	    }
+	}
+	MP_variable f(K,N,N,T);
+	MP_constraint bal(K,N,T), cap(N,N,T);
+	bal(k,i,t) =
+	    sum(N(j), f(k,i,j,t)) - sum(N(j), f(k,j,i,t)) == b(k,i);
+	cap(i,j,t) = sum(K(k), f(k,i,j,t)) <= n;
+	M.setObjective(sum(K(k)*N(i)*N(j)*T(t), (t+1)*cost(i,j)*f(k,i,j,t)));
+	measure(M,r);
+    }
+
+    /// As multiCommodity4(), with 2 modes: flows with 5 indices.
+    void multiCommodity5(MP_model& M, int n, Result& r) {
+	Random random(5);
+	MP_set N(n), K(n/4 < 1 ? 1 : n/4), T(4), Mode(2);
+	MP_index k, i, j, t, m;
+	MP_data cost(N,N), b(K,N);
+	for (int a=0; a<n; a++) {
+	    for (int c=0; c<n; c++) {
+		cost(a,c) = 1+99*random();
+	    }
+	    for (int c=0; c<K.size(); c++) {
+		b(c,a) = (a == c) ? n-1 : -1;
+	    }
+	}
+	MP_variable f(K,N,N,T,Mode);
+	MP_constraint bal(K,N,T), cap(N,N,T,Mode);
+	bal(k,i,t) = sum(N(j)*Mode(m), f(k,i,j,t,m)) -
+	    sum(N(j)*Mode(m), f(k,j,i,t,m)) == b(k,i);
+	cap(i,j,t,m) = sum(K(k), f(k,i,j,t,m)) <= n;
+	M.setObjective(sum(K(k)*N(i)*N(j)*T(t)*Mode(m),
+			   (t+m+1)*cost(i,j)*f(k,i,j,t,m)));
+	measure(M,r);
+    }
+
+    /** Minimum cost flow from one node to all others, over the arcs of
+        an MP_subset: a ring, and 4 random arcs out of every node.
+    */
+    void subsetFlow(MP_model& M, int n, Result& r) {
+	Random random(6);
+	MP_set N(n);
+	MP_subset<2> Arcs(N,N);
+	MP_index i, j;
+	for (int a=0; a<n; a++) {
+	    Arcs.insert(a,(a+1)%n);
+	    for (int c=0; c<4; c++) {
+		Arcs.insert(a,random(n));
+	    }
+	}
+	MP_data cost(Arcs), b(N);
+	for (int l=0; l<Arcs.size(); l++) {
+	    cost(l) = 1+99*random();
+	}
+	for (int a=0; a<n; a++) {
+	    b(a) = (a == 0) ? n-1 : -1;
+	}
+	MP_variable flow(Arcs);
+	MP_constraint bal(N);
+	bal(i) = sum(Arcs(i,j), flow(Arcs(i,j))) -
+	    sum(Arcs(j,i), flow(Arcs(j,i))) == b(i);
+	M.setObjective(sum(Arcs(i,j), cost(Arcs(i,j))*flow(Arcs(i,j))));
+	measure(M,r);
+    }
+
+    /** Assignment of n jobs to n machines, each job allowed on about a
+        tenth of the machines, and on its own.  Every block is filtered
+        with such_that.
+    */
+    void suchThat(MP_model& M, int n, Result& r) {
+	Random random(7);
+	MP_set I(n), J(n);
+	MP_index i, j;
+	MP_data allowed(I,J), cost(I,J);
+	for (int a=0; a<n; a++) {
+	    for (int c=0; c<n; c++) {
+		allowed(a,c) = (a == c || random() < 0.1) ? 1 : 0;
+		cost(a,c) = 1+99*random();
+	    }
+	}
+	MP_variable x(I,J);
+	MP_constraint job(I), machine(J);
+	job(i) = sum(J(j).such_that(allowed(i,j) > 0), x(i,j)) == 1;
+	machine(j) = sum(I(i).such_that(allowed(i,j) > 0), x(i,j)) <= 2;
+	M.setObjective(sum((I(i)*J(j)).such_that(allowed(i,j) > 0),
+			   cost(i,j)*x(i,j)));
+	measure(M,r);
+    }
+
+    struct Model {
+	const char* name;
+	void (*build)(MP_model&, int, Result&);
+	int sizes[3];
+    };
+
+    const Model models[] = {
+	{"transport_dense", transportDense, {50, 100, 200}},
+	{"transport_sparse", transportSparse, {500, 1000, 2000}},
+	{"multicommodity_3", multiCommodity3, {12, 24, 36}},
+	{"multicommodity_4", multiCommodity4, {8, 16, 24}},
+	{"multicommodity_5", multiCommodity5, {8, 12, 16}},
+	{"subset_flow", subsetFlow, {250, 500, 1000}},
+	{"such_that", suchThat, {100, 200, 400}}
+    };
+    const int numModels = sizeof(models)/sizeof(models[0]);
+
+    /// builds, attaches and solves one model of size n, and records it.
+    void runOne(const Model& model, int n, const string& file) {
+	Result r;
+	{
+	    OsiCbcSolverInterface solver;
+	    solver.messageHandler()->setLogLevel(0);
+	    MP_model M(&solver, new Messenger);
+	    model.build(M,n,r);
+	}
+	long peak = -1;
+#ifndef _MSC_VER
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF,&usage) == 0) {
+#ifdef __APPLE__
+	    peak = usage.ru_maxrss/1024;
+#else
+	    peak = usage.ru_maxrss;
+#endif
+	}
+#endif
+	FILE* out = fopen(file.c_str(),"a");
+	if (out == 0) {
+	    cout<<"generationBench: cannot open "<<file<<endl;
+	    return;
+	}
+	fprintf(out,"%s,%d,%d,%d,%d,%.6f,%.6f,%.0f,%ld,%.6f,%s\n",
+		model.name,n,r.rows,r.columns,r.nonzeros,r.attachWall,
+		r.attachCpu,r.attachWall > 0 ? r.nonzeros/r.attachWall : 0.0,
+		peak,r.solveWall,r.status.c_str());
+	fclose(out);
+    }
+
+    /// runs one model, in a process of its own where there are processes.
+    void run(const Model& model, int n, const string& file) {
+	cout<<"generationBench: "<<model.name<<" "<<n<<endl;
+#ifndef _MSC_VER
+	pid_t child = fork();
+	if (child == 0) {
+	    runOne(model,n,file);
+	    _exit(0);
+	} else if (child > 0) {
+	    int status;
+	    waitpid(child,&status,0);
+	    return;
+	}
+#endif
+	runOne(model,n,file);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    string file = "generationBench.csv";
+    int scale = 1;
+    vector<string> selected;
+    for (int a=1; a<argc; a++) {
+	if (strcmp(argv[a],"-o") == 0 && a+1 < argc) {
+	    file = argv[++a];
+	} else if (strcmp(argv[a],"-scale") == 0 && a+1 < argc) {
+	    scale = atoi(argv[++a]);
+	} else if (strcmp(argv[a],"-nosolve") == 0) {
+	    solving = false;
+	} else {
+	    selected.push_back(argv[a]);
+	}
+    }
+    if (scale < 1) {
+	scale = 1;
+    }
+
+    FILE* out = fopen(file.c_str(),"w");
+    if (out == 0) {
+	cout<<"generationBench: cannot open "<<file<<endl;
+	return 1;
+    }
+    fprintf(out,"model,size,rows,columns,nonzeros,attach_seconds,"
+	    "attach_cpu_seconds,nonzeros_per_second,peak_kb,solve_seconds,"
+	    "status\n");
+    fclose(out);
+
+    for (int k=0; k<numModels; k++) {
+	bool wanted = selected.empty();
+	for (size_t s=0; s<selected.size(); s++) {
+	    if (selected[s] == models[k].name) {
+		wanted = true;
+	    }
+	}
+	if (wanted == false) {
+	    continue;
+	}
+	for (int s=0; s<3; s++) {
+	    run(models[k],scale*models[k].sizes[s],file);
+	}
+    }
+    return 0;
+}
@@ -22,6 +22,9 @@ namespace flopc {
 	bool evaluate() const {
 	    return B; 
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return true;
+	}
 	bool B;
     };
 
@@ -32,6 +35,9 @@ namespace flopc {
 	bool evaluate() const {
 	    return C->evaluate(); 
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
 	Constant C;
     };
 
@@ -46,6 +52,9 @@ namespace flopc {
 		return true;
 	    }
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
 	SUBSETREF* C;
     };
 
@@ -56,6 +65,9 @@ namespace flopc {
 	bool evaluate() const {
 	    return !(B->evaluate());
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return B->insertIndices(s);
+	}
 	MP_boolean B;
     };
 
@@ -66,6 +78,9 @@ namespace flopc {
 	bool evaluate() const {
 	    return left->evaluate() && right->evaluate();
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
 	MP_boolean left, right;
     };
 
@@ -76,6 +91,9 @@ namespace flopc {
 	bool evaluate() const {
 	    return left->evaluate() || right->evaluate();
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
 	MP_boolean left, right;
     };
 
@@ -93,6 +111,9 @@ namespace flopc {
     class Comparison : public Boolean_base {
     protected:
 	Comparison(const Constant& e1, const Constant& e2) : left(e1), right(e2) {}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
 	Constant left,right;
     };
 
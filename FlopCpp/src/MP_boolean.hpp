@@ -25,6 +25,10 @@ namespace flopc {
 	friend class MP_boolean;
     public:
 	virtual bool evaluate() const = 0;
+	/// @see Constant_base::insertIndices()
+	virtual bool insertIndices(std::set<const MP_index*>& s) const {
+	    return false;
+	}
     protected:
 	Boolean_base() : count(0) {}
 	virtual ~Boolean_base() {}
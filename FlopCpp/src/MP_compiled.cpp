@@ -0,0 +1,346 @@
+// ******************** FlopCpp **********************************************
+// File: MP_compiled.cpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+//****************************************************************************
+
+#include "MP_compiled.hpp"
+#include "MP_constraint.hpp"
+#include "MP_variable.hpp"
+#include "MP_data.hpp"
+#include "MP_domain.hpp"
+#include "MP_set.hpp"
+
+using namespace flopc;
+using namespace std;
+
+namespace {
+    /** Records the terminal expressions of a constraint, with the planned
+        domain and multiplicators they would be generated over, instead of
+        generating them.
+    */
+    class TermRecorder : public GenerateFunctor {
+    public:
+	struct Term {
+	    Term(const MP_domain& d, const MultiplicatorStack& s, double f,
+		 const TerminalExpression* t) :
+		domain(d), mults(s), m(f), terminal(t) {}
+	    MP_domain domain;
+	    MultiplicatorStack mults;
+	    double m;
+	    const TerminalExpression* terminal;
+	};
+	TermRecorder(vector<Coef>& unused) : GenerateFunctor(unused) {}
+	void forall(const MP_domain& domain) {
+	    terms.push_back(Term(plan(domain),*multiplicators,m_,C));
+	}
+	vector<Term> terms;
+    };
+}
+
+bool CompiledConstraint::compile(MP_constraint& c) {
+    C = &c;
+    terms.clear();
+    registers = 0;
+
+    vector<Coef> unused;
+    TermRecorder recorder(unused);
+    recorder.setConstraint(&c);
+    MultiplicatorStack v;
+    c.left->generate(c.domain(),v,recorder,1.0);
+    c.right->generate(c.domain(),v,recorder,-1.0);
+
+    for (size_t k=0; k<recorder.terms.size(); k++) {
+	const TermRecorder::Term& t = recorder.terms[k];
+	if (lower(t.domain,t.mults,t.m,t.terminal) == false) {
+	    terms.clear();
+	    return false;
+	}
+    }
+    return true;
+}
+
+bool CompiledConstraint::lower(const MP_domain& domain,
+			       const MultiplicatorStack& mults, double m,
+			       const TerminalExpression* t) {
+    terms.push_back(Term());
+    Term& term = terms.back();
+    term.m = m;
+    term.conditions = domain.condition;
+    if (term.conditions.empty() == false) {
+	term.bind = true;
+    }
+    // A level whose index is bound already, by an enclosing walk or an
+    // outer level, is not a loop, as in MP_domain_set::operator()().
+    for (size_t l=0; l<domain.levels.size(); l++) {
+	const MP_domain_base* level = domain.levels[l].operator->();
+	if (level->isRange() == false) {
+	    return false;
+	}
+	MP_index* i = level->getIndex();
+	if (i->isInstantiated() == false && loopOf(term,i) < 0) {
+	    Loop loop;
+	    loop.index = i;
+	    loop.size = level->getSet()->size();
+	    term.loops.push_back(loop);
+	}
+    }
+    if (term.loops.size() > registers) {
+	registers = term.loops.size();
+    }
+
+    lower(term,C->I1,C->S1,term.row[0]);
+    lower(term,C->I2,C->S2,term.row[1]);
+    lower(term,C->I3,C->S3,term.row[2]);
+    lower(term,C->I4,C->S4,term.row[3]);
+    lower(term,C->I5,C->S5,term.row[4]);
+
+    const VariableRef* v = t->getVariableRef();
+    if (v != 0) {
+	term.variable = v->V;
+	lower(term,v->I1,*v->V->S1,term.column[0]);
+	lower(term,v->I2,*v->V->S2,term.column[1]);
+	lower(term,v->I3,*v->V->S3,term.column[2]);
+	lower(term,v->I4,*v->V->S4,term.column[3]);
+	lower(term,v->I5,*v->V->S5,term.column[4]);
+    } else if (t->getConstant() != 0) {
+	term.constant = true;
+	lower(term,t->getConstant(),term.value);
+    } else {
+	term.terminal = t;
+	term.bind = true;
+    }
+
+    term.factors.resize(mults.size());
+    for (size_t k=0; k<mults.size(); k++) {
+	lower(term,mults[k],term.factors[k]);
+    }
+    return true;
+}
+
+void CompiledConstraint::lower(Term& term, const MP_index_exp& e,
+			       const MP_set_base& s, Dimension& d) const {
+    d.size = s.size();
+    d.cyclic = s.Cyclic;
+    d.stage = s.isStage();
+    const MP_index* i = 0;
+    int shift = 0;
+    if (e->getAffine(i,shift) == false) {
+	d.index.exp = e.operator->();
+	term.bind = true;
+    } else if (i == 0) {
+	d.index.shift = shift;
+    } else if (loopOf(term,i) >= 0) {
+	d.index.reg = loopOf(term,i);
+	d.index.shift = shift;
+    } else {
+	// An index no loop of the term binds keeps its value.
+	d.index.exp = e.operator->();
+    }
+}
+
+void CompiledConstraint::lower(Term& term, const Constant_base* c,
+			       Factor& f) const {
+    set<const MP_index*> deps;
+    if (c->insertIndices(deps) == true) {
+	f.level = -1;
+	for (set<const MP_index*>::const_iterator i=deps.begin();
+	     i!=deps.end(); i++) {
+	    f.level = std::max(f.level,loopOf(term,*i));
+	}
+    } else {
+	f.level = static_cast<int>(term.loops.size())-1;
+    }
+    const DataRef* d = c->getDataRef();
+    if (d != 0) {
+	f.data = d->D;
+	f.stochastic = d->stochastic;
+	lower(term,d->I1,d->D->S1,f.dim[0]);
+	lower(term,d->I2,d->D->S2,f.dim[1]);
+	lower(term,d->I3,d->D->S3,f.dim[2]);
+	lower(term,d->I4,d->D->S4,f.dim[3]);
+	lower(term,d->I5,d->D->S5,f.dim[4]);
+    } else {
+	f.exp = c;
+	if (f.level >= 0) {
+	    term.bind = true;
+	}
+    }
+}
+
+int CompiledConstraint::loopOf(const Term& term, const MP_index* i) {
+    for (size_t l=0; l<term.loops.size(); l++) {
+	if (term.loops[l].index == i) {
+	    return static_cast<int>(l);
+	}
+    }
+    return -1;
+}
+
+void CompiledConstraint::evaluate(Factor& f, const int* R) {
+    if (f.data == 0) {
+	f.value = f.exp->evaluate();
+	f.stage = f.exp->getStage();
+	return;
+    }
+    // As DataRef::evaluate() and DataRef::getStage().
+    int i[5];
+    int stage = 0;
+    for (int k=0; k<5; k++) {
+	i[k] = f.dim[k].check(f.dim[k].index.value(R));
+	if (i[k]*f.dim[k].stage > stage) {
+	    stage = i[k]*f.dim[k].stage;
+	}
+    }
+    f.value = f.data->get(i[0],i[1],i[2],i[3],i[4]);
+    f.stage = stage+f.stochastic;
+}
+
+void CompiledConstraint::run(GenerateFunctor& f) {
+    // The data read directly, as DataRef::evaluate() would record them.
+    vector<const MP_data*>* reads = EvaluationContext::current().reads;
+    if (reads != 0) {
+	for (size_t t=0; t<terms.size(); t++) {
+	    for (size_t k=0; k<terms[t].factors.size(); k++) {
+		if (terms[t].factors[k].data != 0) {
+		    reads->push_back(terms[t].factors[k].data);
+		}
+	    }
+	    if (terms[t].value.data != 0) {
+		reads->push_back(terms[t].value.data);
+	    }
+	}
+    }
+    vector<int> R(registers+1);
+    for (size_t t=0; t<terms.size(); t++) {
+	run(terms[t],f,&R[0]);
+    }
+}
+
+void CompiledConstraint::run(Term& term, GenerateFunctor& f, int* R) const {
+    const int L = static_cast<int>(term.loops.size());
+    for (size_t k=0; k<term.factors.size(); k++) {
+	if (term.factors[k].level < 0) {
+	    evaluate(term.factors[k],R);
+	}
+    }
+    if (term.constant == true && term.value.level < 0) {
+	evaluate(term.value,R);
+    }
+    if (L == 0) {
+	emit(term,f,R);
+	return;
+    }
+
+    // The loops are run as an odometer, the last one fastest, which
+    // visits the elements in the same order as MP_domain::Forall().
+    int d = 0;
+    R[0] = -1;
+    if (term.bind == true) {
+	term.loops[0].index->instantiate();
+    }
+    while (d >= 0) {
+	const Loop& loop = term.loops[d];
+	if (++R[d] >= loop.size) {
+	    if (term.bind == true) {
+		loop.index->assign(0);
+		loop.index->unInstantiate();
+	    }
+	    d--;
+	    continue;
+	}
+	if (term.bind == true) {
+	    loop.index->assign(R[d]);
+	}
+	for (size_t k=0; k<term.factors.size(); k++) {
+	    if (term.factors[k].level == d) {
+		evaluate(term.factors[k],R);
+	    }
+	}
+	if (term.constant == true && term.value.level == d) {
+	    evaluate(term.value,R);
+	}
+	if (d == L-1) {
+	    emit(term,f,R);
+	} else {
+	    d++;
+	    R[d] = -1;
+	    if (term.bind == true) {
+		term.loops[d].index->instantiate();
+	    }
+	}
+    }
+}
+
+void CompiledConstraint::emit(const Term& term, GenerateFunctor& f,
+			      const int* R) const {
+    for (size_t k=0; k<term.conditions.size(); k++) {
+	if (term.conditions[k]->evaluate() == false) {
+	    return;
+	}
+    }
+    f.tuples++;
+
+    // As MP_constraint::row_number().
+    int r[5];
+    for (int k=0; k<5; k++) {
+	r[k] = term.row[k].index.value(R);
+	if (term.row[k].check(r[k]) == outOfBound) {
+	    return;
+	}
+    }
+    const int rowNumber = C->offset + C->f(r[0],r[1],r[2],r[3],r[4]);
+    if (rowNumber == outOfBound) {
+	return;
+    }
+
+    int colNumber;
+    double value;
+    int stage;
+    if (term.variable != 0) {
+	// As VariableRef::getColumn().
+	int c[5];
+	for (int k=0; k<5; k++) {
+	    c[k] = term.column[k].check(term.column[k].index.value(R));
+	    if (c[k] == outOfBound) {
+		return;
+	    }
+	}
+	if (c[0] >= term.variable->active ||
+	    c[0] < term.variable->firstGenerated) {
+	    return;
+	}
+	colNumber = term.variable->column(
+	    term.variable->f(c[0],c[1],c[2],c[3],c[4]));
+	value = 1.0;
+	stage = 0;
+    } else if (term.constant == true) {
+	colNumber = -1;
+	value = term.value.value;
+	stage = term.value.stage;
+    } else {
+	colNumber = term.terminal->getColumn();
+	if (colNumber == outOfBound) {
+	    return;
+	}
+	value = term.terminal->getValue();
+	stage = term.terminal->getStage();
+    }
+
+    // The same products, in the same order, as GenerateFunctor.
+    double multiplicator = term.m;
+    int mstage = 0;
+    for (size_t k=0; k<term.factors.size(); k++) {
+	multiplicator *= term.factors[k].value;
+	if (term.factors[k].stage > mstage) {
+	    mstage = term.factors[k].stage;
+	}
+    }
+    if (stage > mstage) {
+	mstage = stage;
+    }
+    f.stored++;
+    f.store(Coef(colNumber,rowNumber,multiplicator*value,mstage));
+}
@@ -0,0 +1,156 @@
+// ******************** FlopCpp **********************************************
+// File: MP_compiled.hpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+// ****************************************************************************
+
+#ifndef _MP_compiled_hpp_
+#define _MP_compiled_hpp_
+
+#include <vector>
+
+#include "MP_expression.hpp"
+#include "MP_boolean.hpp"
+
+namespace flopc {
+
+    class MP_constraint;
+    class MP_variable;
+    class MP_data;
+
+    /** @brief A constraint block lowered to a flat program.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        compile() flattens the expression trees of a constraint block into
+        a list of terms, one for every variable reference or constant in
+        them, each with the loops of its domain, the factors it is
+        multiplied with and the index arithmetic of its row and column.
+        run() then executes the loops directly, without calling through the
+        expression tree or the domain functors.  Every factor is evaluated
+        once per iteration of the innermost loop it depends on.  Data
+        references are read from the data arrays directly; other constants,
+        conditions and index expressions which are neither an index plus
+        a constant nor constant are evaluated through their tree, in which
+        case the loop indices are bound as during a domain walk.  The
+        coefficients are generated in the same order, with the same
+        values, as by walking the tree.
+        @see MP_model::setCompiledGeneration()
+    */
+    class CompiledConstraint {
+    public:
+	CompiledConstraint() : C(0), registers(0) {}
+
+	/** lowers the left and right hand side of c.  Returns false if the
+	    domain of some term is not a product of sets, in which case c
+	    has to be generated by walking its trees.
+	*/
+	bool compile(MP_constraint& c);
+	/// generates the coefficients of the compiled constraint into f.
+	void run(GenerateFunctor& f);
+    private:
+	CompiledConstraint(const CompiledConstraint&);
+	CompiledConstraint& operator=(const CompiledConstraint&);
+
+	/// an index value: R[reg]+shift, shift, or exp->evaluate().
+	struct IndexCode {
+	    IndexCode() : reg(-1), shift(0), exp(0) {}
+	    int value(const int* R) const {
+		if (reg >= 0) {
+		    return R[reg]+shift;
+		} else if (exp == 0) {
+		    return shift;
+		} else {
+		    return exp->evaluate();
+		}
+	    }
+	    int reg;
+	    int shift;
+	    const MP_index_base* exp;
+	};
+
+	/// an index into a set, with the range check of MP_set_base::check().
+	struct Dimension {
+	    Dimension() : size(1), cyclic(false), stage(0) {}
+	    int check(int i) const {
+		if ((i>=0) && (i<size)) {
+		    return i;
+		} else if (cyclic == true) {
+		    return mod(i,size);
+		} else {
+		    return outOfBound;
+		}
+	    }
+	    IndexCode index;
+	    int size;
+	    bool cyclic;
+	    /// MP_set_base::isStage() of the set
+	    int stage;
+	};
+
+	/// a multiplicator, or the value of a constant term.
+	struct Factor {
+	    Factor() : level(-1), data(0), exp(0), stochastic(0),
+		       value(0.0), stage(0) {}
+	    void evaluate(const int* R);
+	    /// the innermost loop the factor depends on, -1 for none
+	    int level;
+	    /// a data reference, read directly
+	    const MP_data* data;
+	    Dimension dim[5];
+	    /// any other constant, evaluated through its tree
+	    const Constant_base* exp;
+	    int stochastic;
+	    double value;
+	    int stage;
+	};
+
+	/// a loop over 0, ..., size-1 of one domain level.
+	struct Loop {
+	    MP_index* index;
+	    int size;
+	};
+
+	/// one terminal expression, with its domain and multiplicators.
+	struct Term {
+	    Term() : m(0.0), variable(0), constant(false), terminal(0),
+		     bind(false) {}
+	    std::vector<Loop> loops;
+	    /// the indices of the constraint
+	    Dimension row[5];
+	    /// the multiplicators, outermost first
+	    std::vector<Factor> factors;
+	    double m;
+	    /// the variable of a variable reference, with its indices
+	    const MP_variable* variable;
+	    Dimension column[5];
+	    /// true for a constant term, whose value is in value
+	    bool constant;
+	    Factor value;
+	    /// any other terminal, evaluated through its tree
+	    const TerminalExpression* terminal;
+	    std::vector<MP_boolean> conditions;
+	    /// true if the loop indices have to be bound in the context
+	    bool bind;
+	};
+
+	bool lower(const MP_domain& domain, const MultiplicatorStack& mults,
+		   double m, const TerminalExpression* t);
+	void lower(Term& term, const MP_index_exp& e, const MP_set_base& s,
+		   Dimension& d) const;
+	void lower(Term& term, const Constant_base* c, Factor& f) const;
+	static int loopOf(const Term& term, const MP_index* i);
+	static void evaluate(Factor& f, const int* R);
+	void run(Term& term, GenerateFunctor& f, int* R) const;
+	void emit(const Term& term, GenerateFunctor& f, const int* R) const;
+
+	const MP_constraint* C;
+	std::vector<Term> terms;
+	/// the largest number of loops of a term
+	size_t registers;
+    };
+
+} // End of namespace flopc
+#endif
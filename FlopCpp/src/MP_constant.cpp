@@ -28,6 +28,12 @@ namespace flopc {
 	double evaluate() const {
 	    return I->evaluate(); 
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return I->insertIndices(s);
+	}
+	bool getAffine(const MP_index*& index, int& shift) const {
+	    return I->getAffine(index,shift);
+	}
 	const MP_index_exp I;
     };
 
@@ -38,6 +44,13 @@ namespace flopc {
 	double evaluate() const { 
 	    return D; 
 	} 
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return true;
+	}
+	bool getValue(double& value) const {
+	    value = D;
+	    return true;
+	}
 	double D;
     };
 
@@ -48,6 +61,9 @@ namespace flopc {
 	double evaluate() const {
 	    return fabs(C->evaluate());
 	}    
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
 	Constant C;
     };
     Constant abs(const Constant& c) {
@@ -66,6 +82,9 @@ namespace flopc {
 		return 0.0;
 	    }
 	}    
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
 	Constant C;
     };
     Constant pos(const Constant& c) {
@@ -79,6 +98,9 @@ namespace flopc {
 	double evaluate() const {
 	    return std::ceil(C->evaluate());
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
 	Constant C;
     };
     Constant ceil(const Constant& c) {
@@ -92,6 +114,9 @@ namespace flopc {
 	double evaluate() const {
 	    return std::floor(C->evaluate());
 	}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
 	Constant C;
     };
     Constant floor(const Constant& c) {
@@ -101,6 +126,15 @@ namespace flopc {
     class Constant_exp : public Constant_base {
     protected:
 	Constant_exp(const Constant& i, const Constant& j) : left(i),right(j) {}
+	bool insertIndices(set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
+	/// sets the operands, for getOperation().
+	bool operands(const Constant_base*& l, const Constant_base*& r) const {
+	    l = left.operator->();
+	    r = right.operator->();
+	    return true;
+	}
 	Constant left, right;
     };
 
@@ -138,6 +172,11 @@ namespace flopc {
 	double evaluate() const {
 	    return left->evaluate()+right->evaluate();
 	}
+	bool getOperation(char& op, const Constant_base*& l,
+			  const Constant_base*& r) const {
+	    op = '+';
+	    return operands(l,r);
+	}
     };
 
     Constant operator+(const Constant& a, const Constant& b) {
@@ -155,6 +194,11 @@ namespace flopc {
 	double evaluate() const {
 	    return left->evaluate()-right->evaluate(); 
 	}
+	bool getOperation(char& op, const Constant_base*& l,
+			  const Constant_base*& r) const {
+	    op = '-';
+	    return operands(l,r);
+	}
     };
 
     Constant operator-(const Constant& a, const Constant& b) {
@@ -172,6 +216,11 @@ namespace flopc {
 	double evaluate() const {
 	    return left->evaluate()*right->evaluate(); 
 	}
+	bool getOperation(char& op, const Constant_base*& l,
+			  const Constant_base*& r) const {
+	    op = '*';
+	    return operands(l,r);
+	}
     };
 
     Constant operator*(const Constant& a, const Constant& b) {
@@ -185,88 +234,92 @@ namespace flopc {
 	double evaluate() const {
 	    return left->evaluate()/right->evaluate(); 
 	}
+	bool getOperation(char& op, const Constant_base*& l,
+			  const Constant_base*& r) const {
+	    op = '/';
+	    return operands(l,r);
+	}
     };
 
     Constant operator/(const Constant& a, const Constant& b) {
 	return new Constant_div(a,b);
     }
    
-    class Constant_max : public Constant_base, public Functor {
+    /** Folds the values of a Constant over a domain walk.  The running
+        value lives on the caller's stack, as a Constant may be evaluated
+        by several threads at once.
+    */
+    class Accumulator : public Functor {
+    public:
+	Accumulator(const Constant& e, double init, double (*f)(double,double))
+	    : exp(e), op(f), value(init) {}
+	void operator()() const {
+	    value = op(value, exp->evaluate());
+	}
+	const Constant& exp;
+	double (*op)(double,double);
+	mutable double value;
+    };
+
+    double accumulateMax(double a, double b) { return b > a ? b : a; }
+    double accumulateMin(double a, double b) { return b < a ? b : a; }
+    double accumulateSum(double a, double b) { return a + b; }
+    double accumulateProduct(double a, double b) { return a * b; }
+
+    class Constant_max : public Constant_base {
 	friend Constant maximum(const MP_domain& i, const Constant& e);
     private:
 	Constant_max(const MP_domain& i, const Constant& e) : d(i), exp(e) {}
-	void operator()() const {
-	    double temp = exp->evaluate();
-	    if (temp > the_max) {
-		the_max = temp;
-	    }
-	}
 	double evaluate() const {    
-	    the_max = DBL_MIN;
-	    d.Forall(this);
-	    return the_max;
+	    Accumulator f(exp, DBL_MIN, accumulateMax);
+	    d.Forall(&f);
+	    return f.value;
 	}
     
 	MP_domain d;
 	Constant exp;
-	mutable double the_max;
     };
 
-    class Constant_min : public Constant_base, public Functor {
+    class Constant_min : public Constant_base {
 	friend Constant minimum(const MP_domain& i, const Constant& e);
     private:
 	Constant_min(const MP_domain& i, const Constant& e) : d(i), exp(e) {}
-	void operator()() const {
-	    double temp = exp->evaluate();
-	    if (temp < the_min) {
-		the_min = temp;
-	    }
-	}
 	double evaluate() const {    
-	    the_min = DBL_MAX;
-	    d.Forall(this);
-	    return the_min;
+	    Accumulator f(exp, DBL_MAX, accumulateMin);
+	    d.Forall(&f);
+	    return f.value;
 	}
 
 	MP_domain d;
 	Constant exp;
-	mutable double the_min;
     };
 
-    class Constant_sum : public Constant_base, public Functor {
+    class Constant_sum : public Constant_base {
 	friend Constant sum(const MP_domain& i, const Constant& e);
     private:
 	Constant_sum(const MP_domain& i, const Constant& e) : d(i), exp(e) {}
-	void operator()() const {
-	    the_sum += exp->evaluate();
-	}
 	double evaluate() const {  
-	    the_sum = 0;
-	    d.Forall(this);
-	    return the_sum;
+	    Accumulator f(exp, 0, accumulateSum);
+	    d.Forall(&f);
+	    return f.value;
 	}
 
 	MP_domain d;
 	Constant exp;
-	mutable double the_sum;
     };
 
-    class Constant_product : public Constant_base, public Functor {
+    class Constant_product : public Constant_base {
 	friend Constant product(const MP_domain& i, const Constant& e);
     private:
 	Constant_product(const MP_domain& i, const Constant& e) : d(i), exp(e) {}
-	void operator()() const {
-	    the_product *= exp->evaluate();
-	}
 	double evaluate() const {  
-	    the_product = 1;
-	    d.Forall(this);
-	    return the_product;
+	    Accumulator f(exp, 1, accumulateProduct);
+	    d.Forall(&f);
+	    return f.value;
 	}
 
 	MP_domain d;
 	Constant exp;
-	mutable double the_product;
     };
 
     Constant maximum(const MP_domain& i, const Constant& e) {
@@ -288,6 +341,9 @@ namespace flopc {
     Constant::Constant(const MP_index_exp& i) :
 	Handle<Constant_base*>(new Constant_index(i)){}
 
+    Constant::Constant(const DataElement& d) :
+	Handle<Constant_base*>(new Constant_double(d)) {}
+
     Constant::Constant(double d) :
 	Handle<Constant_base*>(new Constant_double(d)) {}
 
@@ -9,9 +9,15 @@
 #ifndef _MP_constant_hpp_
 #define _MP_constant_hpp_
 
+#include <set>
+
 #include "MP_utilities.hpp"
 
 namespace flopc {
+    class MP_index;
+    class DataRef;
+    class DataElement;
+
     /** @brief Base class for all "constant" types of data.
     @ingroup INTERNAL_USE
     @note FOR INTERNAL USE: This is not normally used directly by the
@@ -28,6 +34,32 @@ namespace flopc {
 	virtual int stage() const {
 	    return 0;
 	}
+	/** inserts the indices the value depends on into s.  Returns false
+	    if they cannot be determined, in which case the value has to be
+	    assumed to change whenever any index does.
+	*/
+	virtual bool insertIndices(std::set<const MP_index*>& s) const {
+	    return false;
+	}
+	/// returns this if it is a DataRef, 0 otherwise.
+	virtual const DataRef* getDataRef() const {
+	    return 0;
+	}
+	/** returns true if the value is left op right, with op one of
+	    '+', '-', '*' and '/'.  @see DataRef::operator=()
+	*/
+	virtual bool getOperation(char& op, const Constant_base*& left,
+				  const Constant_base*& right) const {
+	    return false;
+	}
+	/// returns true if the value is always value.
+	virtual bool getValue(double& value) const {
+	    return false;
+	}
+	/// @see MP_index_base::getAffine()
+	virtual bool getAffine(const MP_index*& index, int& shift) const {
+	    return false;
+	}
     protected:
 	Constant_base() : count(0) {}
 	virtual ~Constant_base() {}
@@ -36,7 +68,6 @@ namespace flopc {
     };
     
     class MP_index_exp;
-    class DataRef;
     class MP_domain;
 
     /** @brief Reference counted class for all "constant" types of data.
@@ -50,6 +81,8 @@ namespace flopc {
 	Constant(Constant_base* r) : Handle<Constant_base*>(r) {}
 	Constant(const MP_index_exp& i);
 	Constant(const DataRef& d);
+	/// the value of the data element at the time.
+	Constant(const DataElement& d);
 	Constant(double d);
 	Constant(int d);
     };
@@ -9,11 +9,13 @@
 #include <iostream>
 #include <sstream>
 
+#include <OsiSolverInterface.hpp>
 #include "MP_constraint.hpp"
 #include "MP_expression.hpp"
 #include "MP_model.hpp"
 #include "MP_constant.hpp"
 #include "MP_data.hpp"
+#include "MP_compiled.hpp"
 
 using namespace flopc;
 using namespace std;
@@ -23,6 +25,7 @@ void MP_constraint::operator=(const Constraint &v) {
    left = v.left;
    right = v.right;
    sense = v.sense;
+   version++;
 }
 
 int MP_constraint::row_number() const {
@@ -57,22 +60,69 @@ MP_constraint::MP_constraint(
     M(MP_model::current_model),
     offset(-1),
     S1(s1),S2(s2),S3(s3),S4(s4),S5(s5),
-    I1(0),I2(0),I3(0),I4(0),I5(0)
+    I1(0),I2(0),I3(0),I4(0),I5(0),
+    version(0)
 {
     MP_model::current_model->add(*this);
 }
 
+namespace {
+    bool sameCoefficients(const CoefBuffer& a, const CoefBuffer& b) {
+	if (a.size() != b.size()) {
+	    return false;
+	}
+	for (size_t k=0; k<a.size(); k++) {
+	    if (a.col(k) != b.col(k) || a.row(k) != b.row(k) ||
+		a.val(k) != b.val(k) || a.stage(k) != b.stage(k)) {
+		return false;
+	    }
+	}
+	return true;
+    }
+}
+
+void MP_constraint::walk(GenerateFunctor& f) const {
+    MultiplicatorStack v;
+    left->generate(domain(),v,f,1.0);
+    right->generate(domain(),v,f,-1.0);
+}
+
 void MP_constraint::coefficients(GenerateFunctor& f) {
     f.setConstraint(this);
 
-    vector<Constant> v;
-
-        if (I1.operator->()!=0) {
-	left->generate(S1(I1)*S2(I2)*S3(I3)*S4(I4)*S5(I5).such_that(B),v,f,1.0);
- 	right->generate(S1(I1)*S2(I2)*S3(I3)*S4(I4)*S5(I5).such_that(B),v,f,-1.0);
-	 } else {
-		cout<<"FlopCpp Warning: Constraint declared but not defined."<<endl;
+    if (I1.operator->()==0) {
+	cout<<"FlopCpp Warning: Constraint declared but not defined."<<endl;
+	return;
+    }
+    // Generating the terms of one variable only reads part of the data.
+    DataReadRecorder recorder(M->incrementalAttach == true && f.only == 0 ?
+			      &reads : 0);
+    CompiledConstraint program;
+    if (M->compiledGeneration == false || f.only != 0 ||
+	program.compile(*this) == false) {
+	walk(f);
+    } else if (M->compiledCheck == false) {
+	program.run(f);
+    } else {
+	CoefBuffer compiled;
+	CoefBuffer walked;
+	GenerateFunctor cf(compiled);
+	GenerateFunctor wf(walked);
+	cf.setConstraint(this);
+	wf.setConstraint(this);
+	program.run(cf);
+	walk(wf);
+	if (sameCoefficients(compiled,walked) == false) {
+	    cout<<"FlopCpp Warning: Compiled generation of constraint "
+		<<getName()<<" differs from the tree walk, which is used."<<endl;
+	}
+	for (size_t k=0; k<walked.size(); k++) {
+	    f.store(Coef(walked.col(k),walked.row(k),walked.val(k),
+			 walked.stage(k)));
 	}
+	f.tuples += wf.tuples;
+	f.stored += wf.stored;
+    }
 }
 
 void MP_constraint::insertVariables(set<MP_variable*>& v) {
@@ -87,8 +137,11 @@ void MP_constraint::insertVariables(set<MP_variable*>& v) {
 void MP_constraint::display(string s) const {
     cout<<s<<endl;
     if (offset >=0) {
+      // The row bounds are owned by the solver after attach().
+      const double* bl = M->Solver->getRowLower();
+      const double* bu = M->Solver->getRowUpper();
       for (int i=offset; i<offset+size(); i++) {
-	cout<<i<<"  "<<M->bl[i]<<"  "<<M->rowActivity[i]<<"  "<<M->bu[i]<<"  "<<M->rowPrice[i]<<endl;
+	cout<<i<<"  "<<bl[i]<<"  "<<M->rowActivity[i]<<"  "<<bu[i]<<"  "<<M->rowPrice[i]<<endl;
       }
     } else {
       cout<<"No solution available!"<<endl;
@@ -192,6 +192,8 @@ namespace flopc {
     
     */
     class MP_constraint : public RowMajor, public Named {
+	friend class CompiledConstraint;
+	friend class MP_model;
     public: 
         /// construct the MP_constraint with appropriate sets for indexing.
 	MP_constraint(
@@ -210,6 +212,7 @@ namespace flopc {
 	    const MP_index_exp& i5 = MP_index_exp::getEmpty()
 	    )  {
 	    I1 = i1; I2 = i2; I3 = i3; I4 = i4; I5 = i5;
+	    version++;
 	    return *this;
 	}
 
@@ -228,6 +231,7 @@ namespace flopc {
 
 	MP_constraint& such_that(const MP_boolean& b) {
 	    B = b; 
+	    version++;
 	    return *this; 
 	}
 
@@ -242,9 +246,20 @@ namespace flopc {
 	MP_expression left,right;
 	Sense_enum sense;
     private:
+	/// the domain the constraint block is generated over.
+	MP_domain domain() const {
+	    return S1(I1)*S2(I2)*S3(I3)*S4(I4)*S5(I5).such_that(B);
+	}
+	/// generates the coefficients by walking the expression trees.
+	void walk(GenerateFunctor& f) const;
+
 	MP_boolean B;
 	const MP_set_base &S1, &S2, &S3, &S4, &S5; 
 	MP_index_exp I1, I2, I3, I4, I5;
+	/// incremented by every change of the definition
+	int version;
+	/// the data read by the last generation, for incremental attach
+	DataDependencies reads;
     };
 
 }  // End of namespace flopc
@@ -7,6 +7,7 @@
 //****************************************************************************
 
 #include <iostream>
+#include <algorithm>
 
 #include "MP_data.hpp"
 #include "MP_domain.hpp" 
@@ -14,15 +15,216 @@
 #include "MP_set.hpp" 
 #include "MP_constant.hpp" 
 #include "MP_expression.hpp" 
+#include <CoinError.hpp>
+#include <cstdio>
+
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define FLOPC_HAS_MMAP
+#endif
 
 using namespace flopc;
 using namespace std;
 
-double MP_data::outOfBoundData = 0;
+namespace {
+    /** the header of the files of MP_mapped_data, whose size keeps the
+	values following it aligned.
+    */
+    struct MappedHeader {
+	char magic[8];
+	int dimensions;
+	int sizes[5];
+    };
+    const char mappedMagic[8] = {'F','l','o','p','C','p','p','D'};
+    unsigned int hashKey(CoinUInt64 key) {
+	unsigned int h = static_cast<unsigned int>(key)*2654435761u ^ 
+	    static_cast<unsigned int>(key >> 32)*2246822519u;
+	return h ^ (h >> 15);
+    }
+
+    class KeyLess {
+    public:
+	KeyLess(const vector<CoinUInt64>& k) : keys(k) {}
+	bool operator()(int a, int b) const {
+	    return keys[a] < keys[b];
+	}
+    private:
+	const vector<CoinUInt64>& keys;
+    };
+}
+
+SparseValues::SparseValues(int s1, int s2, int s3, int s4, int s5) :
+    defaultValue(0), table(16,-1) {
+    base[0] = s1; base[1] = s2; base[2] = s3; base[3] = s4; base[4] = s5;
+    const CoinUInt64 largest = ~static_cast<CoinUInt64>(0);
+    CoinUInt64 product = 1;
+    for (int j=0; j<5; j++) {
+	if (base[j] > 0 && product > largest/base[j]) {
+	    throw CoinError("too many values for 64 bit keys", 
+			    "SparseValues", "MP_sparse_data");
+	}
+	product *= base[j];
+    }
+}
+
+bool SparseValues::key(int i1, int i2, int i3, int i4, int i5, 
+		       CoinUInt64& k) const {
+    if ( i1==outOfBound || i2==outOfBound || i3==outOfBound ||
+	 i4==outOfBound || i5==outOfBound ) {
+	return false;
+    }
+    k = i1;
+    k = k*base[1] + i2;  k = k*base[2] + i3;
+    k = k*base[3] + i4;  k = k*base[4] + i5;
+    return true;
+}
+
+int SparseValues::find(CoinUInt64 k) const {
+    const size_t mask = table.size()-1;
+    for (size_t s=hashKey(k) & mask; table[s] >= 0; s = (s+1) & mask) {
+	if (keys[table[s]] == k) {
+	    return table[s];
+	}
+    }
+    return -1;
+}
+
+void SparseValues::place(int e) {
+    const size_t mask = table.size()-1;
+    size_t s = hashKey(keys[e]) & mask;
+    while (table[s] >= 0) {
+	s = (s+1) & mask;
+    }
+    table[s] = e;
+}
+
+int SparseValues::insert(CoinUInt64 k, double d) {
+    clearIndexes();
+    keys.push_back(k);
+    values.push_back(d);
+    const int n = static_cast<int>(keys.size());
+    if (2*static_cast<size_t>(n) > table.size()) {
+	table.assign(2*table.size(),-1);
+	for (int e=0; e<n; e++) {
+	    place(e);
+	}
+    } else {
+	place(n-1);
+    }
+    return n-1;
+}
+
+double SparseValues::get(int i1, int i2, int i3, int i4, int i5) const {
+    CoinUInt64 k;
+    if (key(i1,i2,i3,i4,i5,k) == false) {
+	return 0;
+    }
+    const int e = find(k);
+    return e < 0 ? defaultValue : values[e];
+}
+
+void SparseValues::set(int i1, int i2, int i3, int i4, int i5, double d) {
+    CoinUInt64 k;
+    if (key(i1,i2,i3,i4,i5,k) == true) {
+	set(k,d);
+    }
+}
+
+void SparseValues::set(CoinUInt64 k, double d) {
+    const int e = find(k);
+    if (e >= 0) {
+	values[e] = d;
+    } else if (d != defaultValue) {
+	insert(k,d);
+    }
+}
+
+void SparseValues::assign(double d) {
+    defaultValue = d;
+    vector<CoinUInt64>().swap(keys);
+    vector<double>().swap(values);
+    table.assign(16,-1);
+    clearIndexes();
+}
+
+void SparseValues::clearIndexes() {
+    map<int, SubsetIndex*>::iterator i;
+    for (i = indexes.begin(); i != indexes.end(); i++) {
+	delete i->second;
+    }
+    indexes.clear();
+    ordered.clear();
+}
+
+const vector<int>& SparseValues::order() const {
+    ScopedLock guard(indexLock);
+    if (ordered.size() != keys.size()) {
+	sort(ordered);
+    }
+    return ordered;
+}
+
+void SparseValues::find(int bound, const int* key, 
+			const int*& first, const int*& last) const {
+    const vector<int>& o = order();
+    const SubsetIndex* index;
+    {
+	ScopedLock guard(indexLock);
+	map<int, SubsetIndex*>::const_iterator pos = indexes.find(bound);
+	if (pos != indexes.end()) {
+	    index = pos->second;
+	} else {
+	    vector<int> tuples;
+	    int width = 0;
+	    int i[5];
+	    for (int j=0; j<5; j++) {
+		if ((bound & 1<<j) != 0) {
+		    width++;
+		}
+	    }
+	    for (size_t p=0; p<o.size(); p++) {
+		indices(o[p],i);
+		for (int j=0; j<5; j++) {
+		    if ((bound & 1<<j) != 0) {
+			tuples.push_back(i[j]);
+		    }
+		}
+	    }
+	    index = new SubsetIndex(tuples,width);
+	    indexes[bound] = const_cast<SubsetIndex*>(index);
+	}
+    }
+    index->find(key,first,last);
+}
+
+void SparseValues::indices(int e, int* i) const {
+    CoinUInt64 k = keys[e];
+    for (int j=4; j>=0; j--) {
+	i[j] = static_cast<int>(k % base[j]);
+	k /= base[j];
+    }
+}
+
+void SparseValues::sort(vector<int>& order) const {
+    order.resize(keys.size());
+    for (size_t e=0; e<order.size(); e++) {
+	order[e] = static_cast<int>(e);
+    }
+    std::sort(order.begin(),order.end(),KeyLess(keys));
+}
 
 const DataRef& DataRef::operator=(const Constant& c) {
+    D->version++;
     C = c;
-    ((D->S1(I1)*D->S2(I2)*D->S3(I3)*D->S4(I4)*D->S5(I5)).such_that(B)).Forall(this);
+    BulkAssignment bulk;
+    if (bulk.lower(*this,c.operator->()) == true) {
+	bulk.run();
+    } else {
+	((D->S1(I1)*D->S2(I2)*D->S3(I3)*D->S4(I4)*D->S5(I5)).such_that(B)).Forall(this);
+    }
     return *this;;
 }
 
@@ -47,16 +249,58 @@ double DataRef::evaluate() const {
     int i4 = D->S4.check(I4->evaluate());
     int i5 = D->S5.check(I5->evaluate());
 
-    int i = D->f(i1,i2,i3,i4,i5);
-    if ( i ==  outOfBound ) {
-	return 0;
-    } else {
-	return D->v[i];
+    vector<const MP_data*>* reads = EvaluationContext::current().reads;
+    if (reads != 0 && (reads->empty() == true || reads->back() != D)) {
+	reads->push_back(D);
     }
+
+    return D->get(i1,i2,i3,i4,i5);
 }
 
 
 
+MP_domain DataRef::drive(const MP_domain& domain) const {
+    if (D->sparse == 0 || D->sparse->getDefault() != 0.0) {
+	return domain;
+    }
+    const MP_index_exp e[5] = {I1,I2,I3,I4,I5};
+    MP_index* bound[5];
+    bool any = false;
+    for (int j=0; j<5; j++) {
+	const MP_index* i = 0;
+	int shift = 0;
+	bound[j] = 0;
+	if (e[j]->getAffine(i,shift) == false) {
+	    return domain;
+	}
+	if (i == 0 || i == &MP_index::getEmpty()) {
+	    continue;
+	}
+	// The positions not bound are evaluated before binding, so may only
+	// use indices bound already, and a bound index appears once.
+	for (int k=0; k<j; k++) {
+	    if (bound[k] == i) {
+		return domain;
+	    }
+	}
+	if (shift == 0 && i->isInstantiated() == false) {
+	    bound[j] = const_cast<MP_index*>(i);
+	    any = true;
+	} else if (i->isInstantiated() == false) {
+	    return domain;
+	}
+    }
+    if (any == false) {
+	return domain;
+    }
+    return domain.drive(MP_domain(new MP_domain_data(D,e,bound)));
+}
+
+bool DataRef::insertIndices(set<const MP_index*>& s) const {
+    return I1->insertIndices(s) && I2->insertIndices(s) && 
+	I3->insertIndices(s) && I4->insertIndices(s) && I5->insertIndices(s);
+}
+
 int DataRef::getStage() const {
     int i1 = D->S1.checkStage(I1->evaluate());
     int i2 = D->S2.checkStage(I2->evaluate());
@@ -83,23 +327,583 @@ void DataRef::evaluate_lhs(double v) const {
     int i4 = D->S4.check(I4->evaluate());
     int i5 = D->S5.check(I5->evaluate());
 
-    int i = D->f(i1,i2,i3,i4,i5);
-    if (i != outOfBound) {
-	D->v[i] = v;
+    D->set(i1,i2,i3,i4,i5,v);
+}
+
+namespace {
+    /// sets steps to the distances between values along each position.
+    void rowMajorSteps(const MP_set_base* const* S, int* steps) {
+	steps[4] = 1;
+	for (int j=3; j>=0; j--) {
+	    steps[j] = steps[j+1]*S[j+1]->size();
+	}
+    }
+
+    /// the values of an operand over a row, or a single value
+    struct Slot {
+	const double* values;
+	double value;
+	bool single;
+    };
+
+    struct Plus {
+	static double apply(double a, double b) { return a+b; }
+    };
+    struct Minus {
+	static double apply(double a, double b) { return a-b; }
+    };
+    struct Times {
+	static double apply(double a, double b) { return a*b; }
+    };
+    struct Divide {
+	static double apply(double a, double b) { return a/b; }
+    };
+
+    /// sets a to a op b over the n values of a row, kept in out.
+    template<class Op> void combine(Slot& a, const Slot& b, double* out,
+				    int n) {
+	if (a.single == true && b.single == true) {
+	    a.value = Op::apply(a.value,b.value);
+	    return;
+	}
+	if (a.single == true) {
+	    for (int j=0; j<n; j++) {
+		out[j] = Op::apply(a.value,b.values[j]);
+	    }
+	} else if (b.single == true) {
+	    for (int j=0; j<n; j++) {
+		out[j] = Op::apply(a.values[j],b.value);
+	    }
+	} else {
+	    for (int j=0; j<n; j++) {
+		out[j] = Op::apply(a.values[j],b.values[j]);
+	    }
+	}
+	a.values = out;
+	a.single = false;
+    }
+}
+
+int BulkAssignment::loopOf(const MP_index* i) const {
+    for (size_t k=0; k<loops.size(); k++) {
+	if (loops[k] == i) {
+	    return static_cast<int>(k);
+	}
     }
+    return -1;
+}
+
+void BulkAssignment::push(const Code& c) {
+    codes.push_back(c);
+    depth++;
+    maxDepth = std::max(maxDepth,depth);
+}
+
+bool BulkAssignment::lower(const DataRef& r, const Constant_base* c) {
+    D = r.D;
+    if (D->sparse != 0 || r.B.operator->() != 0) {
+	return false;
+    }
+    const MP_index_exp e[5] = {r.I1,r.I2,r.I3,r.I4,r.I5};
+    const MP_set_base* S[5] = {&D->S1,&D->S2,&D->S3,&D->S4,&D->S5};
+    int steps[5];
+    rowMajorSteps(S,steps);
+    int offset = 0;
+    for (int j=0; j<5; j++) {
+	const MP_index* i = 0;
+	int shift = 0;
+	if (e[j]->getAffine(i,shift) == false) {
+	    return false;
+	}
+	// The domain binds the indices not bound yet, and the other
+	// positions are fixed over the assignment.
+	if (i != 0 && i->isInstantiated() == false) {
+	    if (shift != 0 || loopOf(i) >= 0) {
+		return false;
+	    }
+	    step[loops.size()] = steps[j];
+	    loops.push_back(i);
+	    sizes.push_back(S[j]->size());
+	} else {
+	    const int k = S[j]->check((i == 0 ? 0 : i->evaluate())+shift);
+	    if (k == outOfBound) {
+		skip = true;
+	    } else {
+		offset += k*steps[j];
+	    }
+	}
+    }
+    target = D->v+offset;
+    return lower(c);
+}
+
+bool BulkAssignment::lower(const Constant_base* c) {
+    const DataRef* d = c->getDataRef();
+    if (d != 0) {
+	return lower(*d);
+    }
+    Code code;
+    const Constant_base* left;
+    const Constant_base* right;
+    const MP_index* i = 0;
+    int shift = 0;
+    if (c->getOperation(code.op,left,right) == true) {
+	if (lower(left) == false || lower(right) == false) {
+	    return false;
+	}
+	codes.push_back(code);
+	depth--;
+	return true;
+    } else if (c->getValue(code.value) == true) {
+	push(code);
+	return true;
+    } else if (c->getAffine(i,shift) == true) {
+	code.loop = i == 0 ? -1 : loopOf(i);
+	if (code.loop >= 0) {
+	    code.op = 'i';
+	    code.value = shift;
+	} else {
+	    code.value = (i == 0 ? 0 : i->evaluate())+shift;
+	}
+	push(code);
+	return true;
+    }
+    return false;
+}
+
+bool BulkAssignment::lower(const DataRef& r) {
+    const MP_data* E = r.D;
+    if (E->sparse != 0) {
+	return false;
+    }
+    vector<const MP_data*>* reads = EvaluationContext::current().reads;
+    if (reads != 0 && (reads->empty() == true || reads->back() != E)) {
+	reads->push_back(E);
+    }
+    const MP_index_exp e[5] = {r.I1,r.I2,r.I3,r.I4,r.I5};
+    const MP_set_base* S[5] = {&E->S1,&E->S2,&E->S3,&E->S4,&E->S5};
+    int steps[5];
+    rowMajorSteps(S,steps);
+    Code code;
+    code.op = 'd';
+    int offset = 0;
+    bool inside = true;
+    for (int j=0; j<5; j++) {
+	const MP_index* i = 0;
+	int shift = 0;
+	if (e[j]->getAffine(i,shift) == false) {
+	    return false;
+	}
+	const int k = i == 0 ? -1 : loopOf(i);
+	if (k >= 0) {
+	    // The values of the loop, shifted, have to be within the set.
+	    if (shift < 0 || shift+sizes[k] > S[j]->size()) {
+		return false;
+	    }
+	    code.step[k] += steps[j];
+	    offset += shift*steps[j];
+	} else {
+	    const int p = S[j]->check((i == 0 ? 0 : i->evaluate())+shift);
+	    if (p == outOfBound) {
+		inside = false;
+	    } else {
+		offset += p*steps[j];
+	    }
+	}
+    }
+    if (inside == false) {
+	code.op = 'v';
+	code.value = 0.0;
+	push(code);
+	return true;
+    }
+    code.data = E->v+offset;
+    // Every value of the data assigned has to be read before written.
+    if (E == D) {
+	for (size_t k=0; k<loops.size(); k++) {
+	    if (code.step[k] != step[k]) {
+		return false;
+	    }
+	}
+	if (code.data != target) {
+	    return false;
+	}
+    }
+    push(code);
+    return true;
+}
+
+void BulkAssignment::run() const {
+    const int m = static_cast<int>(loops.size());
+    for (int k=0; k<m; k++) {
+	if (sizes[k] == 0) {
+	    return;
+	}
+    }
+    if (skip == true) {
+	return;
+    }
+    // The rows are along the innermost loop, the others counted in count.
+    const int inner = m-1;
+    const int n = m == 0 ? 1 : sizes[inner];
+    vector<double> buffers(maxDepth*n);
+    vector<Slot> stack(maxDepth);
+    vector<int> count(m,0);
+    for (;;) {
+	int d = 0;
+	for (size_t c=0; c<codes.size(); c++) {
+	    const Code& code = codes[c];
+	    double* out = &buffers[0]+d*n;
+	    switch (code.op) {
+	    case 'v':
+		stack[d].single = true;
+		stack[d].value = code.value;
+		d++;
+		break;
+	    case 'i':
+		if (code.loop == inner) {
+		    for (int j=0; j<n; j++) {
+			out[j] = j+code.value;
+		    }
+		    stack[d].values = out;
+		    stack[d].single = false;
+		} else {
+		    stack[d].single = true;
+		    stack[d].value = count[code.loop]+code.value;
+		}
+		d++;
+		break;
+	    case 'd': {
+		const double* p = code.data;
+		for (int k=0; k<inner; k++) {
+		    p += count[k]*code.step[k];
+		}
+		const int s = inner >= 0 ? code.step[inner] : 0;
+		if (s == 0) {
+		    stack[d].single = true;
+		    stack[d].value = *p;
+		} else if (s == 1) {
+		    stack[d].values = p;
+		    stack[d].single = false;
+		} else {
+		    for (int j=0; j<n; j++) {
+			out[j] = p[j*s];
+		    }
+		    stack[d].values = out;
+		    stack[d].single = false;
+		}
+		d++;
+		break;
+	    }
+	    case '+':
+		combine<Plus>(stack[d-2],stack[d-1],out-2*n,n);
+		d--;
+		break;
+	    case '-':
+		combine<Minus>(stack[d-2],stack[d-1],out-2*n,n);
+		d--;
+		break;
+	    case '*':
+		combine<Times>(stack[d-2],stack[d-1],out-2*n,n);
+		d--;
+		break;
+	    case '/':
+		combine<Divide>(stack[d-2],stack[d-1],out-2*n,n);
+		d--;
+		break;
+	    }
+	}
+
+	double* t = target;
+	for (int k=0; k<inner; k++) {
+	    t += count[k]*step[k];
+	}
+	const int s = inner >= 0 ? step[inner] : 0;
+	const Slot& result = stack[0];
+	if (result.single == true) {
+	    for (int j=0; j<n; j++) {
+		t[j*s] = result.value;
+	    }
+	} else if (s == 1) {
+	    for (int j=0; j<n; j++) {
+		t[j] = result.values[j];
+	    }
+	} else {
+	    for (int j=0; j<n; j++) {
+		t[j*s] = result.values[j];
+	    }
+	}
+
+	int k = inner-1;
+	while (k >= 0 && ++count[k] == sizes[k]) {
+	    count[k] = 0;
+	    k--;
+	}
+	if (k < 0) {
+	    return;
+	}
+    }
+}
+
+MP_domain_data::MP_domain_data(const MP_data* d, const MP_index_exp* e,
+			       MP_index* const* i) : 
+    D(d), E(e,e+5), first(-1) {
+    S[0] = &D->S1; S[1] = &D->S2; S[2] = &D->S3; S[3] = &D->S4; S[4] = &D->S5;
+    for (int j=0; j<5; j++) {
+	I[j] = i[j];
+	if (I[j] != 0 && first < 0) {
+	    first = j;
+	}
+    }
+}
+
+int MP_domain_data::evaluate() const {
+    return I[first]->evaluate();
+}
+
+MP_index* MP_domain_data::getIndex() const {
+    return I[first];
+}
+
+const MP_set_base* MP_domain_data::getSet() const {
+    return S[first];
+}
+
+MP_domain MP_domain_data::getDomain(MP_set* s) const {
+    return MP_domain(const_cast<MP_domain_data*>(this));
+}
+
+void MP_domain_data::insertBound(set<const MP_index*>& s) const {
+    for (int j=0; j<5; j++) {
+	if (I[j] != 0) {
+	    s.insert(I[j]);
+	}
+    }
+}
+
+void MP_domain_data::insertRanges(
+    vector<pair<const MP_index*,const MP_set_base*> >& r) const {
+    for (int j=0; j<5; j++) {
+	if (I[j] != 0) {
+	    r.push_back(make_pair(I[j],S[j]));
+	}
+    }
+}
+
+void MP_domain_data::visit(int e, const bool* isBound) const {
+    if (D->sparse->value(e) == 0.0) {
+	return;
+    }
+    int i[5];
+    D->sparse->indices(e,i);
+    for (int j=0; j<5; j++) {
+	if (isBound[j] == false) {
+	    I[j]->assign(i[j]);
+	}
+    }
+    next();
+}
+
+void MP_domain_data::operator()() const {
+    // Read as by DataRef::evaluate(), even if no value is visited.
+    vector<const MP_data*>* reads = EvaluationContext::current().reads;
+    if (reads != 0 && (reads->empty() == true || reads->back() != D)) {
+	reads->push_back(D);
+    }
+    bool isBound[5];
+    int bound = 0;
+    int key[5];
+    int width = 0;
+    for (int j=0; j<5; j++) {
+	isBound[j] = (I[j] == 0 || I[j]->isInstantiated() == true);
+	if (isBound[j] == true) {
+	    const int v = S[j]->check(E[j]->evaluate());
+	    if (v == outOfBound) {
+		return;
+	    }
+	    bound |= 1<<j;
+	    key[width++] = v;
+	}
+    }
+    for (int j=0; j<5; j++) {
+	if (isBound[j] == false) {
+	    I[j]->instantiate();
+	}
+    }
+    const vector<int>& order = D->sparse->order();
+    if (bound == 0) {
+	for (size_t p=0; p<order.size(); p++) {
+	    visit(order[p],isBound);
+	}
+    } else {
+	const int* first;
+	const int* last;
+	D->sparse->find(bound,key,first,last);
+	for (const int* p = first; p != last; p++) {
+	    visit(order[*p],isBound);
+	}
+    }
+    for (int j=0; j<5; j++) {
+	if (isBound[j] == false) {
+	    I[j]->assign(0);
+	    I[j]->unInstantiate();
+	}
+    }
+}
+
+bool DataDependencies::changed() const {
+    for (size_t k=0; k<D.size(); k++) {
+	if (D[k].first->version != D[k].second) {
+	    return true;
+	}
+    }
+    for (size_t k=0; k<S.size(); k++) {
+	if (S[k].first->version != S[k].second) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+void DataDependencies::assign(vector<const MP_data*>& log,
+			      vector<const MP_set_base*>& subsetLog) {
+    sort(log.begin(),log.end());
+    log.erase(unique(log.begin(),log.end()),log.end());
+    D.clear();
+    for (size_t k=0; k<log.size(); k++) {
+	D.push_back(make_pair(log[k],log[k]->version));
+    }
+    sort(subsetLog.begin(),subsetLog.end());
+    subsetLog.erase(unique(subsetLog.begin(),subsetLog.end()),
+		    subsetLog.end());
+    S.clear();
+    for (size_t k=0; k<subsetLog.size(); k++) {
+	S.push_back(make_pair(subsetLog[k],subsetLog[k]->version));
+    }
+}
+
+void MP_data::show(const int* i, double d) const {
+    if (&S1!=&MP_set::getEmpty()) cout << i[0] << " ";
+    if (&S2!=&MP_set::getEmpty()) cout << i[1] << " ";
+    if (&S3!=&MP_set::getEmpty()) cout << i[2] << " ";
+    if (&S4!=&MP_set::getEmpty()) cout << i[3] << " ";
+    if (&S5!=&MP_set::getEmpty()) cout << i[4] << " ";
+    cout<<"  "<<d<< endl;
 }
 
 void MP_data::operator()() const {
-    if (&S1!=&MP_set::getEmpty()) cout << i1.evaluate() << " ";
-    if (&S2!=&MP_set::getEmpty()) cout << i2.evaluate() << " ";
-    if (&S3!=&MP_set::getEmpty()) cout << i3.evaluate() << " ";
-    if (&S4!=&MP_set::getEmpty()) cout << i4.evaluate() << " ";
-    if (&S5!=&MP_set::getEmpty()) cout << i5.evaluate() << " ";
-    cout<<"  "<<v[f(i1.evaluate(),i2.evaluate(),i3.evaluate(),
-		    i4.evaluate(),i5.evaluate())] << endl;
+    const int i[5] = {i1.evaluate(),i2.evaluate(),i3.evaluate(),
+		      i4.evaluate(),i5.evaluate()};
+    show(i,get(i[0],i[1],i[2],i[3],i[4]));
 }
 
 void MP_data::display(string s) {
     cout<<s<<endl;
+    if (sparse != 0) {
+	// Only the values stored, as the domain may be too large to walk.
+	vector<int> order;
+	sparse->sort(order);
+	int i[5];
+	for (size_t e=0; e<order.size(); e++) {
+	    sparse->indices(order[e],i);
+	    show(i,sparse->value(order[e]));
+	}
+	return;
+    }
     ((S1)(i1)*(S2)(i2)*(S3)(i3)*(S4)(i4)*(S5)(i5)).Forall(this);
 }
+
+void MP_data::save(const string& file) const {
+    MappedHeader h;
+    std::copy(mappedMagic,mappedMagic+8,h.magic);
+    const MP_set_base* S[5] = {&S1,&S2,&S3,&S4,&S5};
+    h.dimensions = 0;
+    for (int j=0; j<5; j++) {
+	h.sizes[j] = S[j]->size();
+	if (S[j] != &MP_set::getEmpty()) {
+	    h.dimensions = j+1;
+	}
+    }
+    const double* values = v;
+    vector<double> all;
+    if (sparse != 0) {
+	all.assign(size(),sparse->getDefault());
+	int i[5];
+	for (int e=0; e<sparse->size(); e++) {
+	    sparse->indices(e,i);
+	    all[f(i[0],i[1],i[2],i[3],i[4])] = sparse->value(e);
+	}
+	values = all.empty() ? 0 : &all[0];
+    }
+    FILE* out = fopen(file.c_str(),"wb");
+    if (out == 0) {
+	throw CoinError("cannot create file", "save", "MP_data");
+    }
+    const size_t n = size();
+    const bool ok = fwrite(&h,sizeof(h),1,out) == 1 && 
+	(n == 0 || fwrite(values,sizeof(double),n,out) == n);
+    if (fclose(out) != 0 || ok == false) {
+	throw CoinError("cannot write file", "save", "MP_data");
+    }
+}
+
+MappedFile::MappedFile(const string& name, 
+		       int s1, int s2, int s3, int s4, int s5) : 
+    map(0), length(0), v(0) {
+    const int sizes[5] = {s1,s2,s3,s4,s5};
+    MappedHeader h;
+    FILE* f = fopen(name.c_str(),"rb");
+    if (f == 0) {
+	throw CoinError("cannot open file", "MappedFile", "MP_mapped_data");
+    }
+    size_t n = 1;
+    bool ok = fread(&h,sizeof(h),1,f) == 1 && 
+	std::equal(mappedMagic,mappedMagic+8,h.magic) == true;
+    for (int j=0; ok == true && j<5; j++) {
+	ok = h.sizes[j] == sizes[j];
+	n *= sizes[j];
+    }
+    if (ok == false) {
+	fclose(f);
+	throw CoinError("file not written by MP_data::save() for sets of "
+			"these sizes", "MappedFile", "MP_mapped_data");
+    }
+    length = sizeof(h)+n*sizeof(double);
+#ifdef FLOPC_HAS_MMAP
+    fclose(f);
+    // Private and writable, so that the values may be changed as those
+    // of any MP_data, without changing the file.
+    const int fd = open(name.c_str(),O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd,&st) == 0 && 
+	static_cast<size_t>(st.st_size) >= length) {
+	map = mmap(0,length,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+	if (map == MAP_FAILED) {
+	    map = 0;
+	}
+    }
+    if (fd >= 0) {
+	close(fd);
+    }
+    if (map == 0) {
+	throw CoinError("cannot map file", "MappedFile", "MP_mapped_data");
+    }
+    v = reinterpret_cast<double*>(static_cast<char*>(map)+sizeof(h));
+#else
+    v = new double[n];
+    ok = fread(v,sizeof(double),n,f) == n;
+    fclose(f);
+    if (ok == false) {
+	delete[] v;
+	throw CoinError("cannot read file", "MappedFile", "MP_mapped_data");
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef FLOPC_HAS_MMAP
+    munmap(map,length);
+#else
+    delete[] v;
+#endif
+}
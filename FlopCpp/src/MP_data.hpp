@@ -11,22 +11,94 @@
 
 #include <vector>
 #include <string>
+#include <map>
 
 #include "MP_index.hpp"    
 #include "MP_set.hpp"      
 #include "MP_constant.hpp" 
 #include "MP_boolean.hpp" 
+#include <CoinTypes.hpp>
 
 namespace flopc {
 
     class MP_data;
 
+    /** @brief Storage of the values of a sparse MP_data.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+	calling code.
+	Only the values assigned are stored, each under the row major
+	position of its indices, as a 64 bit key found through an open
+	addressing hash table of the entry numbers.  The other values are
+	the default value.
+    */
+    class SparseValues {
+    public:
+	SparseValues(int s1, int s2, int s3, int s4, int s5);
+	~SparseValues() {
+	    clearIndexes();
+	}
+	/// the value at the checked indices, 0 if out of bound.
+	double get(int i1, int i2, int i3, int i4, int i5) const;
+	/// sets the value at the checked indices, unless out of bound.
+	void set(int i1, int i2, int i3, int i4, int i5, double d);
+	/// sets the value at the row major position k.
+	void set(CoinUInt64 k, double d);
+	/// removes all values, the default value becoming d.
+	void assign(double d);
+	double getDefault() const {
+	    return defaultValue;
+	}
+	/// the number of values stored.
+	int size() const {
+	    return static_cast<int>(keys.size());
+	}
+	/// sets i to the five indices of entry e.
+	void indices(int e, int* i) const;
+	double value(int e) const {
+	    return values[e];
+	}
+	/// sets order to the entry numbers in row major order.
+	void sort(std::vector<int>& order) const;
+	/** returns the entry numbers in row major order, which domains
+	    visit them in.
+	*/
+	const std::vector<int>& order() const;
+	/** sets first and last to the range of the positions in order() of
+	    the entries whose indices j with bit j of bound set are the
+	    values in key, in increasing order of j.
+	*/
+	void find(int bound, const int* key, 
+		  const int*& first, const int*& last) const;
+    private:
+	SparseValues(const SparseValues&);
+	SparseValues& operator=(const SparseValues&);
+	void clearIndexes();
+	bool key(int i1, int i2, int i3, int i4, int i5, CoinUInt64& k) const;
+	int find(CoinUInt64 k) const;
+	int insert(CoinUInt64 k, double d);
+	void place(int e);
+	int base[5];
+	double defaultValue;
+	std::vector<CoinUInt64> keys;
+	std::vector<double> values;
+	/// open addressing table of the entry numbers, -1 for an empty slot
+	std::vector<int> table;
+	/// the entry numbers in row major order
+	mutable std::vector<int> ordered;
+	/// the indexes built by find(), by the indices bound
+	mutable std::map<int, SubsetIndex*> indexes;
+	mutable Mutex indexLock;
+    };
+
     /** @brief Reference to a set of data
         @ingroup INTERNAL_USE
         @note FOR INTERNAL USE: This is not normally used directly by the
 	calling code.
     */
     class DataRef : public Constant_base, public Functor {
+	friend class CompiledConstraint;
+	friend class BulkAssignment;
     public:
 	DataRef(MP_data* d, 
 		const MP_index_exp& i1,
@@ -41,10 +113,21 @@ namespace flopc {
 	DataRef& such_that(const MP_boolean& b);
 	double evaluate() const;
 	int getStage() const;
+	bool insertIndices(std::set<const MP_index*>& s) const;
+	const DataRef* getDataRef() const {
+	    return this;
+	}
 	const DataRef& operator=(const DataRef& r); 
 	const DataRef& operator=(const Constant& c);
 	void evaluate_lhs(double v) const;
 	void operator()() const;
+	/** returns domain driven by the nonzero values of the data, if it
+	    is sparse with the default value 0, by an MP_domain_data
+	    binding the indices used alone, not shifted, which domain binds.
+	    Otherwise, or if MP_domain::drive() cannot insert it, returns
+	    domain.
+	*/
+	MP_domain drive(const MP_domain& domain) const;
     private:
 	MP_data* D;
 	MP_index_exp I1,I2,I3,I4,I5;
@@ -53,6 +136,139 @@ namespace flopc {
 	MP_boolean B;
     };
 
+    /** @brief An assignment to dense data over a block, lowered to
+	array operations.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+	calling code.
+	lower() accepts a left hand side whose indices are either bound by
+	the assignment, each a distinct index not shifted, or fixed, and a
+	right hand side of +, -, * and / over numbers, index expressions
+	and references to dense data, whose indices are loop indices
+	shifted within their sets, or fixed.  run() then computes the
+	values a row of the innermost loop at a time, each operation a
+	loop over arrays, reading the data directly.  The values are those
+	of evaluating the right hand side at every element.
+	@see DataRef::operator=()
+    */
+    class BulkAssignment {
+    public:
+	BulkAssignment() :
+	    skip(false), D(0), target(0), depth(0), maxDepth(0) {}
+	/// returns false if the assignment of c to r cannot be lowered.
+	bool lower(const DataRef& r, const Constant_base* c);
+	void run() const;
+    private:
+	/// a number, an index, a data reference or an operation
+	struct Code {
+	    Code() : op('v'), value(0.0), loop(-1), data(0) {
+		for (int k=0; k<5; k++) {
+		    step[k] = 0;
+		}
+	    }
+	    /// 'v' value, 'i' index, 'd' data or the operation
+	    char op;
+	    /// the number, or the shift of the index
+	    double value;
+	    /// the loop of the index, -1 if fixed
+	    int loop;
+	    /// the first value read, and the step for each loop
+	    const double* data;
+	    int step[5];
+	};
+	bool lower(const Constant_base* c);
+	bool lower(const DataRef& r);
+	int loopOf(const MP_index* i) const;
+	void push(const Code& c);
+	/// true if the left hand side is out of bound
+	bool skip;
+	const MP_data* D;
+	std::vector<const MP_index*> loops;
+	std::vector<int> sizes;
+	/// the first value written, and the step for each loop
+	double* target;
+	int step[5];
+	/// the right hand side in postfix order
+	std::vector<Code> codes;
+	int depth;
+	int maxDepth;
+    };
+
+    /** @brief The indices of the nonzero values of sparse data whose
+	default value is 0, as a level of a domain product.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+	calling code.
+	Binds the indices given, unless bound already, to the indices of
+	each nonzero value stored, in row major order, among those matching
+	the values of the index expressions of the other positions.  The
+	values stored are found through indexes as for subsets.
+	@see DataRef::drive()
+    */
+    class MP_domain_data : public MP_domain_base {
+    public:
+	/** e are the index expressions of the five positions, and i the
+	    index bound at each position, or 0.
+	*/
+	MP_domain_data(const MP_data* d, const MP_index_exp* e, 
+		       MP_index* const* i);
+	void operator()() const;
+	int evaluate() const;
+	MP_index* getIndex() const;
+	const MP_set_base* getSet() const;
+	MP_domain getDomain(MP_set* s) const;
+	void insertBound(std::set<const MP_index*>& s) const;
+	void insertRanges(std::vector<std::pair<const MP_index*,
+			  const MP_set_base*> >& r) const;
+    private:
+	/// binds the indices to those of entry e, if its value is nonzero.
+	void visit(int e, const bool* isBound) const;
+	const MP_data* D;
+	const MP_set_base* S[5];
+	std::vector<MP_index_exp> E;
+	MP_index* I[5];
+	/// the first position binding an index
+	int first;
+    };
+
+    /** @brief A value of an MP_data, as returned by
+	MP_data::operator()(int,...).
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+	calling code.
+	Reads the value when converted to double, and marks the data
+	changed only when assigned to.  Values out of bound read as 0, and
+	assignments to them are ignored.
+    */
+    class DataElement {
+	friend class MP_data;
+    public:
+	operator double() const;
+	DataElement& operator=(double d);
+	DataElement& operator=(const DataElement& e) {
+	    return operator=(static_cast<double>(e));
+	}
+	DataElement& operator+=(double d) {
+	    return operator=(static_cast<double>(*this)+d);
+	}
+	DataElement& operator-=(double d) {
+	    return operator=(static_cast<double>(*this)-d);
+	}
+	DataElement& operator*=(double d) {
+	    return operator=(static_cast<double>(*this)*d);
+	}
+	DataElement& operator/=(double d) {
+	    return operator=(static_cast<double>(*this)/d);
+	}
+    private:
+	DataElement(MP_data* d, int i1, int i2, int i3, int i4, int i5) : 
+	    D(d) {
+	    I[0] = i1; I[1] = i2; I[2] = i3; I[3] = i4; I[4] = i5;
+	}
+	MP_data* D;
+	int I[5];
+    };
+
     /** @brief Input data set.
         @ingroup PublicInterface
         This is one of the main public interface classes.  
@@ -73,13 +289,25 @@ namespace flopc {
 	friend class DisplayData;
 	friend class DataRef;
 	friend class MP_model;
+	friend class CompiledConstraint;
+	friend class DataDependencies;
+	friend class MP_domain_data;
+	friend class DataLoader;
+	friend class BulkAssignment;
+	friend class DataElement;
     public:
 	void operator()() const;
 	/// similar to value() but copies the same value to all entries.
 	void initialize(double d) {
+	    if (sparse != 0) {
+		sparse->assign(d);
+		version++;
+		return;
+	    }
 	    for (int i=0; i<size(); i++) {
 		v[i] = d;
 	    }
+	    version++;
 	}
 	/** Constructs the MP_data object, and allocates space for data, but
 	    does not initialize the data.
@@ -91,7 +319,7 @@ namespace flopc {
 		const MP_set_base &s5 = MP_set::getEmpty()) :
 	    RowMajor(s1.size(),s2.size(),s3.size(),s4.size(),s5.size()),
 	    S1(s1),S2(s2),S3(s3),S4(s4),S5(s5),
-	    v(new double[size()]), manageData(true) 
+	    v(new double[size()]), manageData(true), sparse(0), version(0)
 	    {
 		initialize(0); 
 	    }
@@ -107,12 +335,13 @@ namespace flopc {
 		const MP_set_base &s5 = MP_set::getEmpty()) :
 	    RowMajor(s1.size(),s2.size(),s3.size(),s4.size(),s5.size()),
 	    S1(s1),S2(s2),S3(s3),S4(s4),S5(s5),
-	    v(value), manageData(false) 
+	    v(value), manageData(false), sparse(0), version(0)
 	    {
 	    }
 
 	~MP_data() {
 	    if (manageData == true) delete[] v;
+	    delete sparse;
 	    /// @todo determine cause of seg fault.
 // 	    for (unsigned int i=0; i<myrefs.size(); i++) {
 // 		cout<<"# "<<i<<"   "<<myrefs[i]<<endl;
@@ -122,9 +351,25 @@ namespace flopc {
     
 	/// Used to bind and deep copy data into the MP_data data structure.
 	void value(const double* d) {
-	    for (int i=0; i<size(); i++) {
-		v[i] = d[i];
+	    if (sparse != 0) {
+		for (int i=0; i<size(); i++) {
+		    sparse->set(i,d[i]);
+		}
+	    } else {
+		for (int i=0; i<size(); i++) {
+		    v[i] = d[i];
+		}
 	    }
+	    version++;
+	}
+
+	/** Tells an incrementally attached model that the values have been
+	    changed other than through this class, e.g. through the array
+	    passed to the constructor.
+	    @see MP_model::setIncrementalAttach()
+	*/
+	void markChanged() {
+	    version++;
 	}
 
 	/// @todo purpose?
@@ -133,22 +378,20 @@ namespace flopc {
 	}
     
 	/** Looks up the data based on the index values passed in.
+	    The value is read when converted to double, and written when
+	    assigned to, only which counts as a change of the data.
 	    @note this is used internally, but may also be useful for spot
 	    checking data or in other expressions.
 	*/
-	double& operator()(int lcli1, int lcli2=0, int lcli3=0, int lcli4=0, int lcli5=0) {
-	    lcli1 = S1.check(lcli1);
-	    lcli2 = S2.check(lcli2);
-	    lcli3 = S3.check(lcli3);
-	    lcli4 = S4.check(lcli4);
-	    lcli5 = S5.check(lcli5);
-	    int i = f(lcli1,lcli2,lcli3,lcli4,lcli5);
-	    if (i == outOfBound) {
-		outOfBoundData = 0;
-		return outOfBoundData;
-	    } else {
-		return v[i];
-	    }
+	DataElement operator()(int lcli1, int lcli2=0, int lcli3=0, int lcli4=0, int lcli5=0) {
+	    return DataElement(this,S1.check(lcli1),S2.check(lcli2),
+			       S3.check(lcli3),S4.check(lcli4),
+			       S5.check(lcli5));
+	}
+	/// Looks up the value based on the index values passed in.
+	double operator()(int lcli1, int lcli2=0, int lcli3=0, int lcli4=0, int lcli5=0) const {
+	    return get(S1.check(lcli1),S2.check(lcli2),S3.check(lcli3),
+		       S4.check(lcli4),S5.check(lcli5));
 	}
     
 	/** returns a DataRef which refers into the MP_data.  
@@ -169,20 +412,102 @@ namespace flopc {
 
 	/// For displaying data in a human readable format.
 	void display(std::string s = "");
+	/** Writes the values to a binary file, which MP_mapped_data over
+	    sets of the same sizes maps into memory.
+	*/
+	void save(const std::string& file) const;
     protected:
+	/// Constructs the MP_data object keeping its values in s.
+	MP_data(SparseValues* s,
+		const MP_set_base &s1, const MP_set_base &s2, 
+		const MP_set_base &s3, const MP_set_base &s4, 
+		const MP_set_base &s5) :
+	    RowMajor(s1.size(),s2.size(),s3.size(),s4.size(),s5.size()),
+	    S1(s1),S2(s2),S3(s3),S4(s4),S5(s5),
+	    v(0), manageData(false), sparse(s), version(0)
+	    {
+	    }
 	std::vector<DataRef*> myrefs;
     private:
 	MP_data(const MP_data&); // Forbid copy constructor
 	MP_data& operator=(const MP_data&); // Forbid assignment
 
-	static double outOfBoundData;
+	/// the value at the checked indices, 0 if out of bound.
+	double get(int i1, int i2, int i3, int i4, int i5) const {
+	    if (sparse != 0) {
+		return sparse->get(i1,i2,i3,i4,i5);
+	    }
+	    const int i = f(i1,i2,i3,i4,i5);
+	    return i == outOfBound ? 0 : v[i];
+	}
+	/// sets the value at the checked indices, unless out of bound.
+	void set(int i1, int i2, int i3, int i4, int i5, double d) {
+	    if (sparse != 0) {
+		sparse->set(i1,i2,i3,i4,i5,d);
+		return;
+	    }
+	    const int i = f(i1,i2,i3,i4,i5);
+	    if (i != outOfBound) {
+		v[i] = d;
+	    }
+	}
+	/// displays the value d at the indices i.
+	void show(const int* i, double d) const;
 
 	MP_index i1,i2,i3,i4,i5;
 	const MP_set_base &S1,&S2,&S3,&S4,&S5;
 	double* v;
 	bool manageData;
+	/// the values if sparse, when v is 0
+	SparseValues* sparse;
+	/// incremented by every change of the values
+	int version;
     };
 
+    inline DataElement::operator double() const {
+	return D->get(I[0],I[1],I[2],I[3],I[4]);
+    }
+
+    inline DataElement& DataElement::operator=(double d) {
+	D->set(I[0],I[1],I[2],I[3],I[4],d);
+	D->version++;
+	return *this;
+    }
+
+    /** Two elements are combined as their values, which otherwise could
+	be converted to double as well as to Constant.
+    */
+    inline double operator+(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) + static_cast<double>(b);
+    }
+    inline double operator-(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) - static_cast<double>(b);
+    }
+    inline double operator*(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) * static_cast<double>(b);
+    }
+    inline double operator/(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) / static_cast<double>(b);
+    }
+    inline bool operator==(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) == static_cast<double>(b);
+    }
+    inline bool operator!=(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) != static_cast<double>(b);
+    }
+    inline bool operator<(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) < static_cast<double>(b);
+    }
+    inline bool operator<=(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) <= static_cast<double>(b);
+    }
+    inline bool operator>(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) > static_cast<double>(b);
+    }
+    inline bool operator>=(const DataElement& a, const DataElement& b) {
+	return static_cast<double>(a) >= static_cast<double>(b);
+    }
+
     class MP_stochastic_data : public MP_data {
     public:
 	MP_stochastic_data(const MP_set_base &s1 = MP_set::getEmpty(), 
@@ -205,5 +530,137 @@ namespace flopc {
 	}
     };
 
+    /** @brief Input data set storing only the values assigned.
+        @ingroup PublicInterface
+        Used as MP_data, for data over domains too large to be stored
+        densely, most of whose values are the same.  The values not
+        assigned are 0, or the value last given to initialize(), which
+        also removes all values stored.
+        @note Assigning the default value to a value not stored does not
+        store it, nor does looking it up by operator()(int,...).
+    */
+    class MP_sparse_data : public MP_data {
+    public:
+	MP_sparse_data(const MP_set_base &s1 = MP_set::getEmpty(), 
+		       const MP_set_base &s2 = MP_set::getEmpty(), 
+		       const MP_set_base &s3 = MP_set::getEmpty(),
+		       const MP_set_base &s4 = MP_set::getEmpty(), 
+		       const MP_set_base &s5 = MP_set::getEmpty()) :
+	    MP_data(new SparseValues(s1.size(),s2.size(),s3.size(),
+				     s4.size(),s5.size()),
+		    s1,s2,s3,s4,s5) {}
+    };
+
+    /** @brief A binary file of data values, mapped into memory.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+	calling code.
+	The file, as written by MP_data::save(), has a header giving the
+	number of dimensions and the sizes of the five sets, which must be
+	those given, followed by the values in row major order, in the
+	native byte order.  The mapping is private: the pages are shared
+	between processes until written, and writes do not reach the file.
+	Where memory mapping is not available the values are read instead.
+    */
+    class MappedFile {
+    public:
+	MappedFile(const std::string& name, 
+		   int s1, int s2, int s3, int s4, int s5);
+	~MappedFile();
+	double* values() const {
+	    return v;
+	}
+    private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+	void* map;
+	size_t length;
+	double* v;
+    };
+
+    /** @brief Input data set whose values are those of a binary file,
+	mapped into memory rather than copied.
+        @ingroup PublicInterface
+        Used as MP_data, for large data read by several processes: the
+        operating system shares the pages between them and reads them
+        when first used.  The file is written by MP_data::save() for the
+        same sets, and not changed by changes of the values, which are
+        private to the process.
+    */
+    class MP_mapped_data : private MappedFile, public MP_data {
+    public:
+	MP_mapped_data(const std::string& file,
+		       const MP_set_base &s1 = MP_set::getEmpty(), 
+		       const MP_set_base &s2 = MP_set::getEmpty(), 
+		       const MP_set_base &s3 = MP_set::getEmpty(),
+		       const MP_set_base &s4 = MP_set::getEmpty(), 
+		       const MP_set_base &s5 = MP_set::getEmpty()) :
+	    MappedFile(file,s1.size(),s2.size(),s3.size(),s4.size(),s5.size()),
+	    MP_data(values(),s1,s2,s3,s4,s5) {}
+    };
+
+    /** @brief The MP_data and subsets read while generating part of a
+        model, with their versions at the time.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        Used to find the parts of an attached model affected by changes of
+        the data.  Only data actually read matter: the same generation on
+        the same values read gives the same result.
+    */
+    class DataDependencies {
+    public:
+	/// true if some of the data or subsets have been changed since.
+	bool changed() const;
+	/** replaces the dependencies by the data in log and the subsets in
+	    subsetLog, which may repeat.
+	*/
+	void assign(std::vector<const MP_data*>& log,
+		    std::vector<const MP_set_base*>& subsetLog);
+	void clear() {
+	    D.clear();
+	    S.clear();
+	}
+    private:
+	std::vector<std::pair<const MP_data*,int> > D;
+	std::vector<std::pair<const MP_set_base*,int> > S;
+    };
+
+    /** @brief Records the MP_data read through DataRef::evaluate(), and
+        the subsets read, by the calling thread into a DataDependencies,
+        for the lifetime of the recorder.  Records nothing if constructed
+        with 0.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+    */
+    class DataReadRecorder {
+    public:
+	DataReadRecorder(DataDependencies* d) :
+	    deps(d), ctx(EvaluationContext::current()), saved(ctx.reads),
+	    savedSubsets(ctx.subsetReads) {
+	    if (deps != 0) {
+		ctx.reads = &log;
+		ctx.subsetReads = &subsetLog;
+	    }
+	}
+	~DataReadRecorder() {
+	    if (deps != 0) {
+		ctx.reads = saved;
+		ctx.subsetReads = savedSubsets;
+		deps->assign(log,subsetLog);
+	    }
+	}
+    private:
+	DataReadRecorder(const DataReadRecorder&);
+	DataReadRecorder& operator=(const DataReadRecorder&);
+	DataDependencies* deps;
+	EvaluationContext& ctx;
+	std::vector<const MP_data*>* saved;
+	std::vector<const MP_set_base*>* savedSubsets;
+	std::vector<const MP_data*> log;
+	std::vector<const MP_set_base*> subsetLog;
+    };
+
 } // End of namespace flopc
 #endif
@@ -6,6 +6,8 @@
 // All Rights Reserved.
 //****************************************************************************
 
+#include <algorithm>
+#include <cmath>
 #include "MP_domain.hpp"
 #include "MP_set.hpp"
 #include "MP_boolean.hpp"
@@ -18,42 +20,18 @@ namespace flopc {
     MP_domain MP_domain_set::getDomain(MP_set* s) const {
         return MP_domain(const_cast<MP_domain_set*>(this));
     }
-
-    class Functor_conditional : public Functor {
-    public:
-        Functor_conditional(const Functor* f, const std::vector<MP_boolean> & condition)
-            : F(f), Condition(condition) {}
-	virtual ~Functor_conditional() {}
-	void operator()() const {
-	    bool goOn = true;
-	    for (size_t i = 0; i<Condition.size(); i++) {
-		if (Condition[i]->evaluate()==false) {
-		    goOn = false;
-		    break;
-		}
-	    }
-	    if (goOn == true) {
-		F->operator()();
-	    }
-	}
-	const Functor* F;
-	std::vector<MP_boolean> Condition;
-    };	
 }
 
 using namespace flopc;
 
-const MP_domain* MP_domain::Empty = NULL;
-
 const MP_domain& MP_domain::getEmpty() {
-    if(Empty==NULL) {
-	Empty= new MP_domain(new MP_domain_set(&MP_set::getEmpty(),&MP_set::getEmpty()));
-    }
+    static const MP_domain* Empty = 
+	new MP_domain(new MP_domain_set(&MP_set::getEmpty(),&MP_set::getEmpty()));
     return *Empty;
 }
 
 
-MP_domain_base::MP_domain_base() : count(0), donext(0) {}
+MP_domain_base::MP_domain_base() : count(0) {}
 MP_domain_base::~MP_domain_base() {}
 
 Functor* MP_domain_base::makeInsertFunctor() const {
@@ -71,24 +49,471 @@ void MP_domain_base::display()const {
     MP_model::getCurrentModel()->getMessenger()->logMessage(5,ss.str().c_str());
 }
 
-MP_domain::MP_domain() : Handle<MP_domain_base*>(0), last(0) {}
-MP_domain::MP_domain(MP_domain_base* r) : Handle<MP_domain_base*>(r), last(r) {}
+MP_domain::MP_domain() : Handle<MP_domain_base*>(0) {}
+MP_domain::MP_domain(MP_domain_base* r) : 
+    Handle<MP_domain_base*>(r), levels(1,Handle<MP_domain_base*>(r)) {}
 MP_domain::~MP_domain() {}
 
 MP_domain MP_domain::such_that(const MP_boolean& b) {
     if (b.operator ->() != 0) {
         condition.push_back(b);
+        placeConditions();
     }
     return *this;
 }
 
+void MP_domain::placeConditions() {
+    const int n = static_cast<int>(levels.size());
+    std::vector<std::set<const MP_index*> > bound(n);
+    std::set<const MP_index*> all;
+    for (int l=0; l<n; l++) {
+        levels[l]->insertBound(bound[l]);
+        all.insert(bound[l].begin(),bound[l].end());
+    }
+    // Each condition goes to the first level by which all the indices it
+    // depends on, of those this domain binds, are bound.
+    std::vector<int> level(condition.size());
+    for (size_t k=0; k<condition.size(); k++) {
+        std::set<const MP_index*> deps;
+        if (condition[k]->insertIndices(deps) == false) {
+            level[k] = n-1;
+            continue;
+        }
+        std::set<const MP_index*> unbound;
+        for (std::set<const MP_index*>::const_iterator i=deps.begin();
+             i!=deps.end(); i++) {
+            if (all.count(*i) > 0) {
+                unbound.insert(*i);
+            }
+        }
+        level[k] = -1;
+        for (int l=0; l<n && unbound.empty() == false; l++) {
+            for (std::set<const MP_index*>::const_iterator i=bound[l].begin();
+                 i!=bound[l].end(); i++) {
+                unbound.erase(*i);
+            }
+            level[k] = l;
+        }
+    }
+    placedStart.assign(n+2,0);
+    for (size_t k=0; k<condition.size(); k++) {
+        placedStart[level[k]+2]++;
+    }
+    for (int l=0; l<=n; l++) {
+        placedStart[l+1] += placedStart[l];
+    }
+    placed.resize(condition.size());
+    std::vector<int> fill(placedStart.begin(),placedStart.end()-1);
+    for (size_t k=0; k<condition.size(); k++) {
+        placed[fill[level[k]+1]++] = condition[k];
+    }
+}
+
 void MP_domain::Forall(const Functor* op) const {
-    if (condition.size()>0) {
-        last->donext = new Functor_conditional(op,condition);
-    } else {
-        last->donext = op;
+    if (levels.empty()) {
+        for (size_t k=0; k<placed.size(); k++) {
+            if (placed[k]->evaluate() == false) {
+                return;
+            }
+        }
+        (*op)();
+        return;
+    }
+    const MP_boolean* conditions = placed.empty() ? 0 : &placed[0];
+    const int* start = placed.empty() ? 0 : &placedStart[0];
+    DomainWalk walk(EvaluationContext::current(), &levels[0],
+                    static_cast<int>(levels.size()), op, conditions, start);
+    if (walk.holds(-1) == true) {
+        levels[0]->operator()();
+    }
+}
+
+namespace {
+    /// fraction of the elements a such_that condition is assumed to keep
+    const double conditionSelectivity = 1.0/3.0;
+    /// domain products with more levels are walked in the written order
+    const size_t maxPlannedLevels = 12;
+
+    /** @brief Cost model and search behind MP_domain::plan().
+        @ingroup INTERNAL_USE
+
+        The indices of the domain are numbered, and sets of them kept as
+        bit masks.  A level passes through, calling next() once, when all
+        the indices it would bind are bound; otherwise it visits all the
+        elements of its set, or the elements of its subset matching the
+        indices bound, looked up in the index of the subset.  The number
+        of partial elements
+        reaching a level is estimated from the levels before it as a join
+        of independent, uniformly distributed relations.
+
+        Only orders visiting the same elements are considered: a subset
+        passes through, without checking its elements, exactly when it
+        does in the written order, and the level first binding an index
+        may only change between levels binding it to the same set.
+    */
+    class DomainPlanner {
+    public:
+	DomainPlanner(const std::vector<Handle<MP_domain_base*> >& levels,
+		      const std::vector<MP_boolean>& conditions);
+	/// returns false if the domain cannot be planned.
+	bool ok() const {
+	    return Ok;
+	}
+	/// returns the estimated cost of walking the levels in order.
+	double cost(const std::vector<int>& order) const;
+	/// returns the estimated cost of the cheapest order, stored in order.
+	double best(std::vector<int>& order) const;
+    private:
+	struct Level {
+	    Level() : isSet(false), size(0), binds(0), needs(0), 
+		      never(false), passes(false), active(false) {}
+	    bool isSet;
+	    double size;
+	    unsigned long binds;
+	    /// the indices which, when all bound, make the level pass through
+	    unsigned long needs;
+	    /// true if the level never passes through
+	    bool never;
+	    std::vector<std::pair<int,const MP_set_base*> > ranges;
+	    /// true if the level passes through in the written order
+	    bool passes;
+	    /// true if the level restricts the elements visited
+	    bool active;
+	};
+	int bit(const MP_index* i);
+	int find(const MP_index* i) const;
+	bool passes(int l, unsigned long bound) const {
+	    return L[l].never == false && (L[l].needs & ~bound) == 0;
+	}
+	double visits(int l, unsigned long bound) const;
+	const MP_set_base* range(int l, int k) const;
+	bool sameElements(int l, int w, int k) const;
+	bool valid(int l, unsigned long bound) const;
+	double cardinality(unsigned long levels) const;
+
+	bool Ok;
+	std::vector<Level> L;
+	std::vector<const MP_index*> indices;
+	/// the level binding each index first in the written order, or -1
+	std::vector<int> driver;
+	/// the number of values of each index
+	std::vector<double> values;
+	unsigned long external;
+	/// the indices each condition depends on, when known
+	std::vector<unsigned long> conditions;
+    };
+
+    DomainPlanner::DomainPlanner(
+	const std::vector<Handle<MP_domain_base*> >& levels,
+	const std::vector<MP_boolean>& C) : 
+	Ok(true), L(levels.size()), external(0) {
+	for (size_t l=0; l<levels.size(); l++) {
+	    Level& v = L[l];
+	    v.isSet = levels[l]->isRange();
+	    v.size = levels[l]->getSet()->size();
+	    std::set<const MP_index*> b;
+	    levels[l]->insertBound(b);
+	    for (std::set<const MP_index*>::const_iterator i=b.begin();
+		 i!=b.end(); i++) {
+		if (*i == 0) {
+		    Ok = false;
+		} else if (*i != &MP_index::getEmpty() && bit(*i) >= 0) {
+		    v.binds |= 1ul<<bit(*i);
+		}
+	    }
+	    std::vector<std::pair<const MP_index*,const MP_set_base*> > r;
+	    levels[l]->insertRanges(r);
+	    for (size_t j=0; j<r.size(); j++) {
+		if (r[j].first == 0) {
+		    Ok = false;
+		} else if (r[j].first == &MP_index::getEmpty()) {
+		    v.never = true;
+		} else if (bit(r[j].first) >= 0) {
+		    const int k = bit(r[j].first);
+		    v.needs |= 1ul<<k;
+		    v.ranges.push_back(std::make_pair(k,r[j].second));
+		}
+	    }
+	}
+	if (Ok == false) {
+	    return;
+	}
+	for (size_t k=0; k<indices.size(); k++) {
+	    if (indices[k]->isInstantiated() == true) {
+		external |= 1ul<<k;
+	    }
+	}
+
+	driver.assign(indices.size(),-1);
+	values.assign(indices.size(),0.0);
+	unsigned long bound = external;
+	for (size_t l=0; l<L.size(); l++) {
+	    Level& v = L[l];
+	    v.passes = passes(l,bound);
+	    for (size_t j=0; j<v.ranges.size(); j++) {
+		const int k = v.ranges[j].first;
+		if (values[k] == 0.0) {
+		    values[k] = std::max(1,v.ranges[j].second->size());
+		}
+		if ((bound & 1ul<<k) == 0 && driver[k] < 0) {
+		    driver[k] = l;
+		}
+	    }
+	    bound |= v.binds;
+	}
+	// A set level binding an index bound already does not check its
+	// value, so it only restricts the elements if it might bind it.
+	for (size_t l=0; l<L.size(); l++) {
+	    Level& v = L[l];
+	    if (v.isSet == false) {
+		v.active = (v.passes == false);
+	    } else if (v.ranges.empty() == false) {
+		const int k = v.ranges[0].first;
+		v.active = driver[k] >= 0 && sameElements(l,driver[k],k);
+	    }
+	}
+
+	for (size_t c=0; c<C.size(); c++) {
+	    std::set<const MP_index*> deps;
+	    if (C[c]->insertIndices(deps) == false) {
+		continue;
+	    }
+	    unsigned long m = 0;
+	    for (std::set<const MP_index*>::const_iterator i=deps.begin();
+		 i!=deps.end(); i++) {
+		const int k = find(*i);
+		if (k >= 0) {
+		    m |= 1ul<<k;
+		}
+	    }
+	    if ((m & ~external) != 0) {
+		conditions.push_back(m);
+	    }
+	}
+    }
+
+    int DomainPlanner::find(const MP_index* i) const {
+	for (size_t k=0; k<indices.size(); k++) {
+	    if (indices[k] == i) {
+		return static_cast<int>(k);
+	    }
+	}
+	return -1;
+    }
+
+    int DomainPlanner::bit(const MP_index* i) {
+	int k = find(i);
+	if (k < 0) {
+	    // The bits an unsigned long is guaranteed to have.
+	    if (indices.size() >= 32) {
+		Ok = false;
+		return -1;
+	    }
+	    k = static_cast<int>(indices.size());
+	    indices.push_back(i);
+	}
+	return k;
+    }
+
+    const MP_set_base* DomainPlanner::range(int l, int k) const {
+	for (size_t j=0; j<L[l].ranges.size(); j++) {
+	    if (L[l].ranges[j].first == k) {
+		return L[l].ranges[j].second;
+	    }
+	}
+	return 0;
+    }
+
+    /** returns true if the elements visited are the same when level l
+        binds index k first instead of level w.  Subset levels check the
+        value of an index bound already, set levels do not.  The values
+        of the elements of a subset are within its cyclic sets only
+        modulo their size.
+    */
+    bool DomainPlanner::sameElements(int l, int w, int k) const {
+	if (l == w || (L[l].isSet == false && L[w].isSet == false)) {
+	    return true;
+	}
+	const MP_set_base* s = range(l,k);
+	if (s == 0 || s != range(w,k)) {
+	    return false;
+	}
+	return (L[l].isSet == true && L[w].isSet == true) || s->Cyclic == false;
+    }
+
+    bool DomainPlanner::valid(int l, unsigned long bound) const {
+	const Level& v = L[l];
+	if (v.isSet == false && passes(l,bound) != v.passes) {
+	    return false;
+	}
+	for (size_t j=0; j<v.ranges.size(); j++) {
+	    const int k = v.ranges[j].first;
+	    if ((bound & 1ul<<k) == 0 && 
+		(driver[k] < 0 || sameElements(l,driver[k],k) == false)) {
+		return false;
+	    }
+	}
+	return true;
+    }
+
+    double DomainPlanner::cardinality(unsigned long levels) const {
+	double c = 1.0;
+	unsigned long bound = external;
+	std::vector<int> count(indices.size(),0);
+	for (size_t l=0; l<L.size(); l++) {
+	    if ((levels & 1ul<<l) == 0) {
+		continue;
+	    }
+	    bound |= L[l].binds;
+	    if (L[l].active == true) {
+		c *= L[l].size;
+		for (size_t j=0; j<L[l].ranges.size(); j++) {
+		    count[L[l].ranges[j].first]++;
+		}
+	    }
+	}
+	for (size_t k=0; k<indices.size(); k++) {
+	    if (count[k] > 0) {
+		const int e = (external & 1ul<<k) != 0 ? -count[k] : 1-count[k];
+		c *= std::pow(values[k],e);
+	    }
+	}
+	for (size_t k=0; k<conditions.size(); k++) {
+	    if ((conditions[k] & ~bound) == 0) {
+		c *= conditionSelectivity;
+	    }
+	}
+	return c;
+    }
+
+    double DomainPlanner::visits(int l, unsigned long bound) const {
+	if (passes(l,bound) == true) {
+	    return 1.0;
+	}
+	double v = L[l].size;
+	if (L[l].isSet == false && (L[l].needs & bound) != 0) {
+	    for (size_t j=0; j<L[l].ranges.size(); j++) {
+		if ((bound & 1ul<<L[l].ranges[j].first) != 0) {
+		    v /= values[L[l].ranges[j].first];
+		}
+	    }
+	    // The lookup.
+	    v += 1.0;
+	}
+	return v;
+    }
+
+    double DomainPlanner::cost(const std::vector<int>& order) const {
+	double c = 0.0;
+	unsigned long levels = 0;
+	unsigned long bound = external;
+	for (size_t p=0; p<order.size(); p++) {
+	    const int l = order[p];
+	    c += cardinality(levels)*visits(l,bound);
+	    levels |= 1ul<<l;
+	    bound |= L[l].binds;
+	}
+	return c;
+    }
+
+    double DomainPlanner::best(std::vector<int>& order) const {
+	// Dynamic programming over the sets of outer levels, which
+	// determine the elements reaching the next level.
+	const int n = static_cast<int>(L.size());
+	const unsigned long all = (1ul<<n)-1;
+	std::vector<double> costs(all+1,HUGE_VAL);
+	std::vector<int> last(all+1,-1);
+	std::vector<unsigned long> bound(all+1,external);
+	costs[0] = 0.0;
+	for (unsigned long m=0; m<all; m++) {
+	    if (costs[m] == HUGE_VAL) {
+		continue;
+	    }
+	    const double c = cardinality(m);
+	    for (int l=0; l<n; l++) {
+		if ((m & 1ul<<l) != 0 || valid(l,bound[m]) == false) {
+		    continue;
+		}
+		const unsigned long next = m | 1ul<<l;
+		const double v = costs[m] + c*visits(l,bound[m]);
+		if (v < costs[next]) {
+		    costs[next] = v;
+		    last[next] = l;
+		    bound[next] = bound[m] | L[l].binds;
+		}
+	    }
+	}
+	order.resize(n);
+	unsigned long m = all;
+	for (int p=n-1; p>=0; p--) {
+	    order[p] = last[m];
+	    m &= ~(1ul<<last[m]);
+	}
+	return costs[all];
+    }
+}
+
+MP_domain MP_domain::plan() const {
+    if (levels.size() < 2 || levels.size() > maxPlannedLevels) {
+        return *this;
+    }
+    DomainPlanner planner(levels,condition);
+    if (planner.ok() == false) {
+        return *this;
+    }
+    std::vector<int> written(levels.size());
+    for (size_t l=0; l<levels.size(); l++) {
+        written[l] = static_cast<int>(l);
+    }
+    std::vector<int> order;
+    if (2*planner.best(order) >= planner.cost(written)) {
+        return *this;
+    }
+    MP_domain retval(*this);
+    for (size_t l=0; l<levels.size(); l++) {
+        retval.levels[l] = levels[order[l]];
+    }
+    retval.placeConditions();
+    return retval;
+}
+
+MP_domain MP_domain::drive(const MP_domain& s) const {
+    std::vector<std::pair<const MP_index*,const MP_set_base*> > r;
+    s->insertRanges(r);
+    size_t first = levels.size();
+    for (size_t j=0; j<r.size(); j++) {
+        if (r[j].first->isInstantiated() == true) {
+            continue;
+        }
+        size_t driver = levels.size();
+        for (size_t l=0; l<levels.size(); l++) {
+            std::set<const MP_index*> b;
+            levels[l]->insertBound(b);
+            if (b.count(r[j].first) == 0) {
+                continue;
+            }
+            if (levels[l]->isRange() == false) {
+                return *this;
+            }
+            if (driver == levels.size()) {
+                if (levels[l]->getSet() != r[j].second) {
+                    return *this;
+                }
+                driver = l;
+            }
+        }
+        if (driver == levels.size()) {
+            return *this;
+        }
+        first = std::min(first,driver);
+    }
+    if (first == levels.size()) {
+        return *this;
     }
-    operator->()->operator()();
+    MP_domain retval(*this);
+    retval.levels.insert(retval.levels.begin()+first,s.levels[0]);
+    retval.placeConditions();
+    return retval;
 }
 
 const MP_set_base* MP_domain_set::getSet() const {
@@ -105,12 +530,12 @@ int MP_domain_set::evaluate() const {
 
 void MP_domain_set::operator()() const {
     if (I->isInstantiated() == true) {
-        (*donext)(); 
+        next(); 
     } else {
         I->instantiate();
         for (int k=0; k<S->size(); k++) {
             I->assign(k);
-            (*donext)();
+            next();
         }
         I->assign(0);
         I->unInstantiate();
@@ -129,12 +554,11 @@ flopc::MP_domain flopc::operator*(const flopc::MP_domain& a, const flopc::MP_dom
         return a;
     } else {
         MP_domain retval = a;
-        retval.last->donext = b.operator->();
-        const_cast<MP_domain&>(b).increment();
-        const_cast<MP_domain&>(a).increment();
-        retval.last = b.last;
+        retval.levels.insert(retval.levels.end(),b.levels.begin(),
+                             b.levels.end());
         retval.condition.insert(retval.condition.end(),b.condition.begin(),
 				b.condition.end());
+        retval.placeConditions();
         return retval;
     }
 
@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include "MP_utilities.hpp"
 #include "MP_boolean.hpp" 
 #include "MP_index.hpp" 
@@ -42,9 +43,96 @@ public:
     virtual const MP_set_base* getSet() const = 0;
     void display()const;
     virtual size_t size() const ;
-    const Functor* donext;
+    /** returns true if operator()() binds getIndex() to 0, 1, ...,
+        getSet()->size()-1 in turn, unless it is bound already.
+    */
+    virtual bool isRange() const {
+        return false;
+    }
+    /// inserts the indices operator()() binds into s.
+    virtual void insertBound(std::set<const MP_index*>& s) const {
+        s.insert(getIndex());
+    }
+    /** inserts the indices operator()() binds, unless they are all bound
+        already, each with the set whose range holds the values it binds
+        them to.
+    */
+    virtual void insertRanges(std::vector<std::pair<const MP_index*,
+                              const MP_set_base*> >& r) const {
+        r.push_back(std::make_pair(getIndex(),getSet()));
+    }
+protected:
+    /** Continues the domain walk in progress with the next level of the
+        domain product, or with the functor passed to MP_domain::Forall()
+        after the last level.  Called by operator()() for each element.
+    */
+    void next() const;
+};
+
+    /** @brief State of one MP_domain::Forall() call.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        Walks are kept in the EvaluationContext of the calling thread, so
+        domain objects are never modified by iterating over them, and may
+        be shared between threads.  A walk is the innermost one of its
+        context for the lifetime of the object.
+    */
+class DomainWalk {
+public:
+    /** The conditions checked after level l has bound its indices are
+        conditions[start[l+1]] up to conditions[start[l+2]], if conditions
+        is not 0.
+    */
+    DomainWalk(EvaluationContext& c, const Handle<MP_domain_base*>* l, 
+	       int n, const Functor* f, const MP_boolean* conditions = 0,
+	       const int* start = 0) : 
+	levels(l), size(n), level(0), op(f), Conditions(conditions), 
+	Start(start), ctx(c), outer(c.walk) {
+	ctx.walk = this;
+    }
+    ~DomainWalk() {
+	ctx.walk = outer;
+    }
+    /// returns true if the conditions checked after level l hold.
+    bool holds(int l) const {
+	if (Conditions != 0) {
+	    for (int k=Start[l+1]; k<Start[l+2]; k++) {
+		if (Conditions[k]->evaluate() == false) {
+		    return false;
+		}
+	    }
+	}
+	return true;
+    }
+    const Handle<MP_domain_base*>* levels;
+    int size;
+    int level;
+    const Functor* op;
+private:
+    /// the such_that conditions of the domain, not copied.
+    const MP_boolean* Conditions;
+    const int* Start;
+    DomainWalk(const DomainWalk&);
+    DomainWalk& operator=(const DomainWalk&);
+    EvaluationContext& ctx;
+    DomainWalk* outer;
 };
 
+inline void MP_domain_base::next() const {
+    DomainWalk& w = *EvaluationContext::current().walk;
+    if (w.holds(w.level) == false) {
+	return;
+    }
+    const int l = ++w.level;
+    if (l == w.size) {
+	(*w.op)();
+    } else {
+	w.levels[l]->operator()();
+    }
+    w.level = l-1;
+}
+
     /** @brief Range over which some other constuct is defined.
         @ingroup PublicInterface
         This is one of the main public interface classes.  One uses this in
@@ -63,6 +151,7 @@ class MP_domain : public Handle<MP_domain_base*> {
     
     friend class MP_constraint;
     friend class MP_index_exp;
+    friend class CompiledConstraint;
 public:
     /** @briefConstructs a set  which points to nothing.
         @note This is not the same as the "empty" set.
@@ -87,14 +176,43 @@ public:
     This method will call the functor for each member of the MP_domain.
      */
     void Forall(const Functor* op) const;
+    /** returns the domain with the levels of the product reordered to
+        minimise the estimated number of elements visited by Forall(),
+        which visits the same elements, possibly in another order.  The
+        estimates use the sizes of the sets and subsets and assume that
+        every such_that condition keeps a third of the elements.  The
+        written order is kept unless another one at least halves the
+        estimate, and the order only depends on the domain and on which
+        of its indices are bound already.
+    */
+    MP_domain plan() const;
+    /** returns the domain with level s inserted before the outermost
+        level first binding one of the indices s binds, each of which
+        must be bound first by a set level over the set s binds it in,
+        and by no subset.  The set levels then only visit the values s
+        binds their indices to.  Returns the domain itself if s cannot be
+        inserted so, or binds no index the domain does not bind already.
+    */
+    MP_domain drive(const MP_domain& s) const;
     /// returns number of elements in the domain.
     size_t size() const;
     /// returns a reference to the "empty" set.
     static const MP_domain& getEmpty();
 private:
+    /** orders the conditions by the level of the domain product after
+        which they can be checked: the innermost level binding an index
+        they depend on.  Conditions depending on no level are checked
+        before the walk, those with unknown dependencies after the last
+        level.
+    */
+    void placeConditions();
 	std::vector<MP_boolean> condition;
-    Handle<MP_domain_base*> last;
-    static const MP_domain* Empty;
+    /// the factors of a domain product, outermost first.
+    std::vector<Handle<MP_domain_base*> > levels;
+    /// condition ordered by placeConditions().
+    std::vector<MP_boolean> placed;
+    /// where the conditions of each level start in placed, as for DomainWalk.
+    std::vector<int> placedStart;
 };
 
     /** @brief Range over which some other constuct is defined.
@@ -125,6 +243,9 @@ public:
         @todo Is internal? can be private? or needs more doc.
     */
     MP_domain getDomain(MP_set* s) const ;
+    bool isRange() const {
+        return true;
+    }
     ~MP_domain_set();
 private:
     const MP_set* S;
@@ -183,6 +304,16 @@ public:
     MP_index* getIndex() const {
 	return S;
     }
+    void insertBound(std::set<const MP_index*>& s) const {
+	s.insert(S);
+	s.insert(I.begin(),I.end());
+    }
+    void insertRanges(std::vector<std::pair<const MP_index*,
+		      const MP_set_base*> >& r) const {
+	for (int j=0; j<nbr; j++) {
+	    r.push_back(std::make_pair(I[j],S->S[j]));
+	}
+    }
     /** @note Internal use. 
         @todo Is internal? can be private? or needs more doc.
     */
@@ -204,27 +335,64 @@ public:
 		}
 	    }
 	}
+	// The positions bound before this level, and their values.  An index
+	// repeated after a position binding it is checked against the value
+	// bound there, which only the full scan does.
+	int bound = 0;
+	int key[nbr];
+	int width = 0;
+	for (int j=0; j<nbr; j++) {
+	    if (isBound[j] == true) {
+		for (int k=0; k<j; k++) {
+		    if (isBound[k] == false && I[k] == I[j]) {
+			bound = -1;
+		    }
+		}
+		if (bound >= 0) {
+		    bound |= 1<<j;
+		    key[width++] = I[j]->evaluate();
+		}
+	    }
+	}
+	S->recordRead();
 	if (allBound == true) {
-	    (*donext)(); 
+	    next(); 
+	} else if (bound > 0) {
+	    // Only the matching elements, from the index of the subset.
+	    const int* first;
+	    const int* last;
+	    S->find(bound,key,first,last);
+	    const std::vector<int>& order = S->order();
+	    int e[nbr];
+	    for (const int* p = first; p != last; p++) {
+		S->assign(*p);
+		S->values(order[*p],e);
+		for (int j=0; j<nbr; j++) {
+		    if (isBound[j] == false) {
+			I[j]->assign(e[j]);
+		    }
+		}
+		next();
+	    }
 	} else {
-	    std::map<std::vector<int>, int>::const_iterator i;
-	    int counter = 0;
-	    for (i = S->elements.begin(); i != S->elements.end(); i++) {
-		S->assign(counter);
-		counter++;
+	    const std::vector<int>& order = S->order();
+	    int e[nbr];
+	    for (size_t counter = 0; counter < order.size(); counter++) {
+		S->assign(static_cast<int>(counter));
+		S->values(order[counter],e);
 		bool goOn = true;
 		for (int j=0; j<nbr; j++) {
 		    if (isBound[j] == true) {
-			if (I[j]->evaluate() != i->first[j]) {
+			if (I[j]->evaluate() != e[j]) {
 			    goOn = false;
 			    break;
 			}
 		    } else {
-			I[j]->assign(i->first[j]);
+			I[j]->assign(e[j]);
 		    }
 		}
 		if (goOn == true) {
-		    (*donext)();
+		    next();
 		}
 	    }
 	}
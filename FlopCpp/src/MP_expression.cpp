@@ -7,12 +7,14 @@
 //****************************************************************************
 
 #include <sstream>
+#include <algorithm>
 #include "MP_expression.hpp"
 #include "MP_constant.hpp"
 #include "MP_boolean.hpp"
 #include "MP_constraint.hpp"
 #include "MP_set.hpp"
 #include "MP_variable.hpp"
+#include "MP_data.hpp"
 
 using namespace std;
 
@@ -36,14 +38,20 @@ private:
 	return C->getStage(); //NB to be changed
     }
     void generate(const MP_domain& domain,
-		  vector<Constant> multiplicators,
+		  MultiplicatorStack& multiplicators,
 		  GenerateFunctor& f,
 		  double m) const {
+	if (f.only != 0) {
+	    return;
+	}
 	f.setMultiplicator(multiplicators,m);
 	f.setTerminalExpression(this);
-	domain.Forall(&f);
+	f.forall(domain);
     }
     void insertVariables(set<MP_variable*>& v) const {}
+    const Constant_base* getConstant() const {
+	return C.operator->();
+    }
 
     Constant C;
 };
@@ -59,7 +67,7 @@ private:
 	return left->level()+right->level(); 
     }
     void generate(const MP_domain& domain,
-		  vector<Constant> multiplicators,
+		  MultiplicatorStack& multiplicators,
 		  GenerateFunctor& f,
 		  double m) const { 
 	left->generate(domain, multiplicators,f,m);
@@ -78,7 +86,7 @@ private:
 	return left->level()-right->level(); 
     }
     void generate(const MP_domain& domain,
-		  vector<Constant> multiplicators,
+		  MultiplicatorStack& multiplicators,
 		  GenerateFunctor& f,
 		  double m) const {
 	left->generate(domain, multiplicators,f,m);
@@ -97,11 +105,12 @@ private:
 	return left->evaluate()*right->level(); 
     }
     void generate(const MP_domain& domain,
-		  vector<Constant> multiplicators,
+		  MultiplicatorStack& multiplicators,
 		  GenerateFunctor& f,
 		  double m) const {
-	multiplicators.push_back(left);
+	multiplicators.push_back(left.operator->());
 	right->generate(domain, multiplicators, f, m);
+	multiplicators.pop_back();
     }
     void insertVariables(set<MP_variable*>& v) const {
 	right->insertVariables(v);
@@ -110,31 +119,39 @@ private:
     MP_expression right;
 };
 
-class Expression_sum : public MP_expression_base, public Functor {
+class Expression_sum : public MP_expression_base {
     friend MP_expression sum(const MP_domain& d, const MP_expression& e);
 private:
     Expression_sum(const MP_domain& d, const MP_expression& e) : 
 	D(d), exp(e) {}
-    void operator()() const {
-	the_sum += exp->level();
-    }
+    // Keeps the running sum on the caller's stack, as the expression may
+    // be evaluated by several threads at once.
+    class SumFunctor : public Functor {
+    public:
+	SumFunctor(const MP_expression& e) : exp(e), the_sum(0) {}
+	void operator()() const {
+	    the_sum += exp->level();
+	}
+	const MP_expression& exp;
+	mutable double the_sum;
+    };
     double level() const {
-	the_sum = 0;
-	D.Forall(this);
-	return the_sum;
+	SumFunctor f(exp);
+	D.Forall(&f);
+	return f.the_sum;
     } 
     void generate(const MP_domain& domain,
-		  vector<Constant> multiplicators,
+		  MultiplicatorStack& multiplicators,
 		  GenerateFunctor& f,
 		  double m) const {
-	// The order, D*domain (NOT domain*D), is important for efficiency! 
+	// D*domain walks the summation outermost, which MP_domain::plan()
+	// keeps unless another order is much cheaper.
 	exp->generate(D*domain, multiplicators, f, m); 
     }
     void insertVariables(set<MP_variable*>& v) const {
 	exp->insertVariables(v);
     }
 
-    mutable double the_sum;
     MP_domain D;
     MP_expression exp;
 };
@@ -185,19 +202,119 @@ MP_expression::MP_expression(const Constant &c) :
 MP_expression::MP_expression(const VariableRef &v) : 
     Handle<MP_expression_base*>(const_cast<VariableRef*>(&v)) {} 
 
+void CoefBuffer::append(const CoefBuffer& b) {
+    if (b.staged == true && staged == false) {
+	stages.assign(vals.size(),0);
+	staged = true;
+    }
+    cols.insert(cols.end(),b.cols.begin(),b.cols.end());
+    rows.insert(rows.end(),b.rows.begin(),b.rows.end());
+    vals.insert(vals.end(),b.vals.begin(),b.vals.end());
+    if (b.staged == true) {
+	stages.insert(stages.end(),b.stages.begin(),b.stages.end());
+    } else if (staged == true) {
+	stages.resize(vals.size(),0);
+    }
+}
+
+void CoefBuffer::copy(vector<Coef>& v) const {
+    v.reserve(v.size()+size());
+    for (size_t k=0; k<size(); k++) {
+	v.push_back(Coef(cols[k],rows[k],vals[k],stage(k)));
+    }
+}
+
+MP_domain GenerateFunctor::plan(const MP_domain& domain) const {
+    MP_domain d = domain.plan();
+    for (size_t k=0; k<multiplicators->size(); k++) {
+	const DataRef* r = (*multiplicators)[k]->getDataRef();
+	if (r != 0) {
+	    d = r->drive(d);
+	}
+    }
+    const Constant_base* c = C->getConstant();
+    if (c != 0 && c->getDataRef() != 0) {
+	d = c->getDataRef()->drive(d);
+    }
+    return d;
+}
+
 int GenerateFunctor::row_number() const {
     return R->row_number();
 }
 
-void GenerateFunctor::operator()() const {
-    double multiplicator = m_;
-    int stage = 0;
-    for (unsigned int i=0; i<multiplicators.size(); i++) {
-	multiplicator *= multiplicators[i]->evaluate();
-	if (multiplicators[i]->getStage() > stage) {
-	    stage = multiplicators[i]->getStage();
+void GenerateFunctor::setMultiplicator(const MultiplicatorStack& mults, 
+				       double m) {
+    multiplicators = &mults;
+    m_ = m;
+
+    const size_t K = mults.size();
+    depIndex.clear();
+    depOf.clear();
+    depStart.assign(1,0);
+    always.assign(K,false);
+    for (size_t k=0; k<K; k++) {
+	set<const MP_index*> deps;
+	if (mults[k]->insertIndices(deps) == false) {
+	    always[k] = true;
+	}
+	for (set<const MP_index*>::const_iterator i=deps.begin(); 
+	     i!=deps.end(); i++) {
+	    size_t d = find(depIndex.begin(),depIndex.end(),*i)-
+		depIndex.begin();
+	    if (d == depIndex.size()) {
+		depIndex.push_back(*i);
+	    }
+	    depOf.push_back(static_cast<int>(d));
 	}
+	depStart.push_back(static_cast<int>(depOf.size()));
     }
+    depValue.resize(depIndex.size());
+    depChanged.resize(depIndex.size());
+    factor.resize(K);
+    factorStage.resize(K);
+    product.resize(K+1);
+    productStage.resize(K+1);
+    product[0] = m;
+    productStage[0] = 0;
+    primed = false;
+}
+
+void GenerateFunctor::updateMultiplicators() const {
+    const MultiplicatorStack& mults = *multiplicators;
+    const size_t K = mults.size();
+    for (size_t d=0; d<depIndex.size(); d++) {
+	const int v = depIndex[d]->evaluate();
+	depChanged[d] = (primed == false || v != depValue[d]);
+	depValue[d] = v;
+    }
+    size_t first = K;
+    for (size_t k=0; k<K; k++) {
+	bool changed = (primed == false || always[k] == true);
+	for (int l=depStart[k]; changed == false && l<depStart[k+1]; l++) {
+	    changed = depChanged[depOf[l]];
+	}
+	if (changed == true) {
+	    factor[k] = mults[k]->evaluate();
+	    factorStage[k] = mults[k]->getStage();
+	    if (k < first) {
+		first = k;
+	    }
+	}
+    }
+    for (size_t k=first; k<K; k++) {
+	product[k+1] = product[k]*factor[k];
+	productStage[k+1] = std::max(productStage[k],factorStage[k]);
+    }
+    primed = true;
+}
+
+void GenerateFunctor::operator()() const {
+    tuples++;
+    updateMultiplicators();
+    const size_t K = multiplicators->size();
+    double multiplicator = product[K];
+    int stage = productStage[K];
     int rowNumber = row_number();
     if (rowNumber != outOfBound) {
 	int colNumber = C->getColumn();
@@ -209,7 +326,8 @@ void GenerateFunctor::operator()() const {
 	    }
 	    // For the SP core it might be usefull to generate zero coefs
 	    // if (val != 0) {
-	    Coefs.push_back(Coef(colNumber, rowNumber, val, stage));
+	    stored++;
+	    store(Coef(colNumber, rowNumber, val, stage));
 	    //}
 	}
     }
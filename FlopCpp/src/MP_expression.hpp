@@ -38,26 +38,129 @@ namespace flopc {
 	double val;
     };
 
+    /** @brief Compact store of coefficients, as a structure of arrays.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        Holds the same information as a std::vector<Coef>, in 16 instead
+        of 24 bytes per coefficient.  The stage lane is only allocated
+        when the first coefficient with a nonzero stage is stored, which
+        only happens for models indexed over an MP_stage.  Until then
+        stage() returns 0.
+    */
+    class CoefBuffer {
+    public:
+	CoefBuffer() : staged(false) {}
+
+	size_t size() const {
+	    return vals.size();
+	}
+	bool empty() const {
+	    return vals.empty();
+	}
+	/// true if some coefficient has a nonzero stage.
+	bool hasStages() const {
+	    return staged;
+	}
+	void reserve(size_t n) {
+	    cols.reserve(n);
+	    rows.reserve(n);
+	    vals.reserve(n);
+	}
+	/// removes all coefficients, but keeps the allocated capacity.
+	void clear() {
+	    cols.clear();
+	    rows.clear();
+	    vals.clear();
+	    stages.clear();
+	    staged = false;
+	}
+	void push_back(int c, int r, double v, int s = 0) {
+	    if (s != 0 && staged == false) {
+		stages.assign(vals.size(),0);
+		staged = true;
+	    }
+	    cols.push_back(c);
+	    rows.push_back(r);
+	    vals.push_back(v);
+	    if (staged == true) {
+		stages.push_back(s);
+	    }
+	}
+	void push_back(const Coef& c) {
+	    push_back(c.col,c.row,c.val,c.stage);
+	}
+	void append(const CoefBuffer& b);
+	/// copies the coefficients into v.
+	void copy(std::vector<Coef>& v) const;
+	/// bytes allocated for the coefficients.
+	size_t bytes() const {
+	    return (cols.capacity()+rows.capacity()+stages.capacity())*
+		sizeof(int) + vals.capacity()*sizeof(double);
+	}
+
+	int col(size_t k) const {
+	    return cols[k];
+	}
+	int row(size_t k) const {
+	    return rows[k];
+	}
+	double val(size_t k) const {
+	    return vals[k];
+	}
+	int stage(size_t k) const {
+	    return staged ? stages[k] : 0;
+	}
+    private:
+	std::vector<int> cols;
+	std::vector<int> rows;
+	std::vector<double> vals;
+	std::vector<int> stages;
+	bool staged;
+    };
+
     class TerminalExpression;
 
+    /** @brief The Constant factors enclosing the part of an expression
+        being generated, outermost first.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        It is used as a stack: Expression_mult pushes its factor before
+        generating its operand and pops it afterwards.  The entries point
+        into the expression tree, which outlives the generation, so no
+        reference counts are touched, and once the stack has grown to the
+        depth of the tree nothing is allocated.
+    */
+    typedef std::vector<const Constant_base*> MultiplicatorStack;
+
     /** @brief Functor to facilitate generation of coefficients.
         @ingroup INTERNAL_USE
         @note FOR INTERNAL USE: This is not normally used directly by the
         calling code.
+        The multiplicators are tagged with the indices they depend on (see
+        Constant_base::insertIndices()) by setMultiplicator().  Each is
+        then only re-evaluated for the elements of the domain where one of
+        those indices has changed, i.e. once per iteration of its
+        innermost dependent loop.  The product is kept as running partial
+        products, so only the part from the first changed factor on is
+        recomputed, in the same order as before.
     */
     class GenerateFunctor : public Functor {
     public:
-	GenerateFunctor(std::vector<Coef>& coefs) : Coefs(coefs) {}
+	GenerateFunctor(std::vector<Coef>& coefs) : 
+	    multiplicators(0), Coefs(&coefs), Buffer(0), only(0), tuples(0), 
+	    stored(0), primed(false) {}
+	GenerateFunctor(CoefBuffer& coefs) : 
+	    multiplicators(0), Coefs(0), Buffer(&coefs), only(0), tuples(0), 
+	    stored(0), primed(false) {}
 
 	virtual ~GenerateFunctor(){}
 
 	void setConstraint(MP_constraint* r) {
 	    R = r;
 	}
-	void setMultiplicator(std::vector<Constant>& mults, double m) {
-	    multiplicators = mults;
-	    m_ = m;
-	}
+	void setMultiplicator(const MultiplicatorStack& mults, double m);
 	void setTerminalExpression(const TerminalExpression* c) {
 	    C = c;
 	}
@@ -65,11 +168,62 @@ namespace flopc {
 
 	void operator()() const;
 
+	/** generates the terminal expression set by setTerminalExpression()
+	    for every element of domain, by default through Forall() of
+	    plan(domain).
+	*/
+	virtual void forall(const MP_domain& domain) {
+	    plan(domain).Forall(this);
+	}
+	/** returns the domain to generate the current term over: the
+	    MP_domain::plan() of domain, driven by the nonzero values of the
+	    sparse data among the multiplicators and the terminal expression,
+	    as the coefficients are 0 elsewhere.  @see DataRef::drive()
+	*/
+	MP_domain plan(const MP_domain& domain) const;
+
+	/// stores one generated coefficient, by default in Coefs or Buffer.
+	virtual void store(const Coef& c) const {
+	    if (Buffer != 0) {
+		Buffer->push_back(c);
+	    } else {
+		Coefs->push_back(c);
+	    }
+	}
+
 	double m_;
-	std::vector<Constant> multiplicators;
+	const MultiplicatorStack* multiplicators;
 	MP_constraint* R;
 	const TerminalExpression* C;
-	std::vector<Coef>& Coefs;
+	std::vector<Coef>* Coefs;
+	CoefBuffer* Buffer;
+	/// if set, only the terms of this variable are generated, neither
+	/// those of other variables nor constants
+	const MP_variable* only;
+	/// number of domain elements generated for
+	mutable size_t tuples;
+	/// number of coefficients passed to store()
+	mutable size_t stored;
+    private:
+	/// evaluates the multiplicators which may have changed.
+	void updateMultiplicators() const;
+
+	/// the distinct indices the multiplicators depend on
+	std::vector<const MP_index*> depIndex;
+	/// multiplicator k depends on depIndex[depOf[depStart[k]..depStart[k+1]-1]]
+	std::vector<int> depOf;
+	std::vector<int> depStart;
+	/// true for multiplicators with unknown dependencies
+	std::vector<bool> always;
+	/// values of depIndex at the previous element
+	mutable std::vector<int> depValue;
+	mutable std::vector<bool> depChanged;
+	mutable std::vector<double> factor;
+	mutable std::vector<int> factorStage;
+	/// partial products and stages of the first k multiplicators
+	mutable std::vector<double> product;
+	mutable std::vector<int> productStage;
+	mutable bool primed;
     };
 
     /** @brief Functor to facilitate generation of the objective function.
@@ -80,6 +234,7 @@ namespace flopc {
     class ObjectiveGenerateFunctor : public GenerateFunctor {
     public:
 	ObjectiveGenerateFunctor(std::vector<Coef>& coefs) : GenerateFunctor(coefs) {}
+	ObjectiveGenerateFunctor(CoefBuffer& coefs) : GenerateFunctor(coefs) {}
 	virtual int row_number() const {
 	    return -1;
 	}
@@ -100,7 +255,7 @@ namespace flopc {
 
 	virtual double level() const = 0;
 	virtual void generate(const MP_domain& domain,
-			      std::vector<Constant> multiplicators,
+			      MultiplicatorStack& multiplicators,
 			      GenerateFunctor& f,
 			      double m) const = 0;
 	virtual void insertVariables(std::set<MP_variable*>& v) const = 0;
@@ -146,6 +301,14 @@ namespace flopc {
 	virtual double getValue() const = 0; 
 	virtual int getColumn() const = 0;
 	virtual int getStage() const = 0;
+	/// returns this if it is a VariableRef, 0 otherwise.
+	virtual const VariableRef* getVariableRef() const {
+	    return 0;
+	}
+	/// returns the value of a constant term, 0 for other terminals.
+	virtual const Constant_base* getConstant() const {
+	    return 0;
+	}
     };
 
     /** @brief The base class for all expressions.
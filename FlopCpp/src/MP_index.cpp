@@ -7,6 +7,7 @@
 //****************************************************************************
 
 #include "MP_index.hpp"
+#include "MP_parallel.hpp"
 #include "MP_domain.hpp"
 #include "MP_set.hpp"
 #include "MP_model.hpp"
@@ -17,6 +18,50 @@ namespace flopc {
     MP_index& MP_index::Any = *new MP_index();
     MP_index_exp MP_index_exp::Empty =  *new MP_index_exp(Constant(0.0));
 
+    int MP_index::nextSlot = 0;
+    FLOPC_THREAD_LOCAL EvaluationContext* EvaluationContext::Current = 0;
+
+    namespace {
+	// The slots of destroyed indices, used again first, so that the
+	// bindings of a context only grow with the indices alive at once.
+	struct SlotPool {
+	    Mutex lock;
+	    std::vector<int> free;
+	};
+	// Made on first use, as indices are made by static initialisers,
+	// and never destroyed, as they are destroyed by static destructors.
+	SlotPool& slotPool() {
+	    static SlotPool* pool = new SlotPool;
+	    return *pool;
+	}
+    }
+
+    int MP_index::newSlot() {
+	SlotPool& pool = slotPool();
+	ScopedLock guard(pool.lock);
+	if (pool.free.empty() == false) {
+	    const int s = pool.free.back();
+	    pool.free.pop_back();
+	    return s;
+	}
+	return nextSlot++;
+    }
+
+    void MP_index::releaseSlot(int s) {
+	// Only the calling thread's context, and the default one, outlive
+	// the walks an index is bound in.
+	EvaluationContext::current().clear(s);
+	EvaluationContext::getDefault().clear(s);
+	SlotPool& pool = slotPool();
+	ScopedLock guard(pool.lock);
+	pool.free.push_back(s);
+    }
+
+    EvaluationContext& EvaluationContext::getDefault() {
+	static EvaluationContext* context = new EvaluationContext;
+	return *context;
+    }
+
     MP_index &MP_index::getEmpty() {
 	return Empty;
     }
@@ -45,6 +90,18 @@ namespace flopc {
 	virtual MP_domain getDomain(MP_set* s) const{
 	    return MP_domain::getEmpty();
 	}
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    return C->insertIndices(s);
+	}
+	bool getAffine(const MP_index*& index, int& shift) const {
+	    std::set<const MP_index*> s;
+	    if (C->insertIndices(s) == false || s.empty() == false) {
+		return false;
+	    }
+	    index = 0;
+	    shift = int(C->evaluate());
+	    return true;
+	}
 	Constant C;
     };
 
@@ -65,6 +122,9 @@ namespace flopc {
 	virtual MP_domain getDomain(MP_set* s) const{
 	    return MP_domain(S->getDomain(s));
 	}
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    return S->insertIndices(s);
+	}
 	const SUBSETREF* S;
     };
   
@@ -120,7 +180,7 @@ MP_index_exp::MP_index_exp(const Constant& c) :
     Handle<MP_index_base*>(new MP_index_constant(c)) {}
 
 MP_index_exp::MP_index_exp(MP_index& i) : 
-    Handle<MP_index_base*>(&i) { operator->()->count++; }
+    Handle<MP_index_base*>(&i) { atomicAdd(operator->()->count, 1); }
 
 MP_index_exp::MP_index_exp(const MP_index_exp &other):
 	Handle<MP_index_base*>((const Handle<MP_index_base*> &)other) {}
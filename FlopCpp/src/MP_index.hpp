@@ -9,6 +9,8 @@
 #ifndef _MP_index_hpp_
 #define _MP_index_hpp_
 
+#include <vector>
+
 #include "MP_utilities.hpp"
 #include "MP_constant.hpp"
 
@@ -17,6 +19,8 @@ namespace flopc {
     class MP_index;
     class MP_domain;
     class MP_set;
+    class MP_set_base;
+    class MP_data;
 
     /** @brief Internal representation of a index
         @ingroup INTERNAL_USE
@@ -31,6 +35,16 @@ namespace flopc {
 	virtual MP_index* getIndex() const = 0;
 	virtual MP_domain getDomain(MP_set* s) const = 0;
 	virtual void display()const;
+	/// @see Constant_base::insertIndices()
+	virtual bool insertIndices(std::set<const MP_index*>& s) const {
+	    return false;
+	}
+	/** returns true if the value is index->evaluate()+shift, or just
+	    shift if index is set to 0.  @see CompiledConstraint
+	*/
+	virtual bool getAffine(const MP_index*& index, int& shift) const {
+	    return false;
+	}
     protected:
 	MP_index_base() : count(0) {}
 	virtual ~MP_index_base() {}
@@ -38,6 +52,103 @@ namespace flopc {
 	int count;
     };
 
+    class DomainWalk;
+
+    /** @brief Index bindings and domain walk state of one thread or task.
+        @ingroup INTERNAL_USE
+        The values of all MP_index objects, and whether they are currently
+        instantiated by an enclosing domain iteration, are kept here rather
+        than in the MP_index objects themselves.  Every thread (or task)
+        which walks domains concurrently with others must install a context
+        of its own with a ContextBinder; the WorkerPool does this for its
+        workers.  Threads which never install one share a default context,
+        which is what single threaded code uses.
+    */
+    class EvaluationContext {
+	friend class ContextBinder;
+	friend class MP_index;
+    public:
+	EvaluationContext() : walk(0), reads(0), subsetReads(0) {}
+
+	/// returns the context of the calling thread.
+	static EvaluationContext& current() {
+	    EvaluationContext* c = Current;
+	    return (c != 0) ? *c : getDefault();
+	}
+
+	int value(int slot) const {
+	    return (slot < static_cast<int>(bindings.size())) ?
+		bindings[slot].value : 0;
+	}
+	bool isInstantiated(int slot) const {
+	    return (slot < static_cast<int>(bindings.size())) &&
+		bindings[slot].instantiated;
+	}
+	void assign(int slot, int v) {
+	    binding(slot).value = v;
+	}
+	void setInstantiated(int slot, bool b) {
+	    binding(slot).instantiated = b;
+	}
+	/// unbinds slot, before it is used by another index.
+	void clear(int slot) {
+	    if (slot < static_cast<int>(bindings.size())) {
+		bindings[slot] = Binding();
+	    }
+	}
+
+	/// innermost domain walk in progress, see MP_domain::Forall()
+	DomainWalk* walk;
+	/// if set, the MP_data read by DataRef::evaluate() are appended
+	/// @see DataReadRecorder
+	std::vector<const MP_data*>* reads;
+	/// if set, the subsets read by domains over them and by
+	/// SubsetRef::evaluate() are appended
+	/// @see DataReadRecorder
+	std::vector<const MP_set_base*>* subsetReads;
+    private:
+	EvaluationContext(const EvaluationContext&);
+	EvaluationContext& operator=(const EvaluationContext&);
+
+	struct Binding {
+	    Binding() : value(0), instantiated(false) {}
+	    int value;
+	    bool instantiated;
+	};
+	Binding& binding(int slot) {
+	    if (slot >= static_cast<int>(bindings.size())) {
+		bindings.resize(slot+1);
+	    }
+	    return bindings[slot];
+	}
+	static EvaluationContext& getDefault();
+
+	std::vector<Binding> bindings;
+	static FLOPC_THREAD_LOCAL EvaluationContext* Current;
+    };
+
+    /** @brief Installs an EvaluationContext for the calling thread for the
+        lifetime of the binder.
+        @ingroup INTERNAL_USE
+        <code>
+        EvaluationContext ctx;<br>
+        ContextBinder bind(ctx); // index bindings of this task live in ctx
+        </code>
+    */
+    class ContextBinder {
+    public:
+	ContextBinder(EvaluationContext& c) : saved(EvaluationContext::Current) {
+	    EvaluationContext::Current = &c;
+	}
+	~ContextBinder() {
+	    EvaluationContext::Current = saved;
+	}
+    private:
+	ContextBinder(const ContextBinder&);
+	ContextBinder& operator=(const ContextBinder&);
+	EvaluationContext* saved;
+    };
+
     /** @brief Representation of an index.
         @ingroup PublicInterface
         This is one of the main public interface classes.  
@@ -49,38 +160,49 @@ namespace flopc {
         @li there is a special "empty" which is a unique constant. \
         This constant is used when defaulting passed parameters for \
         extra dimensions which are unused.
+        @note the current value of the index is held by the
+        EvaluationContext of the calling thread.
     */
     class MP_index : public MP_index_base {
     public:
         /// Default constructor. 
-	MP_index() : index(0), instantiated(false) {}
+	MP_index() : slot(newSlot()) {}
+	/// A copy is a distinct index, which starts out unbound.
+	MP_index(const MP_index& other) : MP_index_base(), slot(newSlot()) {}
+	/// The slot of the index is used again by indices made later.
+	~MP_index() {
+	    releaseSlot(slot);
+	}
+	MP_index& operator=(const MP_index& other) {
+	    return *this;
+	}
 	int evaluate() const { 
-	    return index; 
+	    return EvaluationContext::current().value(slot); 
 	}
     /** interrogate state of instatiation of data.
         @todo should this be private?
     */
 	bool isInstantiated() const { 
-	    return instantiated; 
+	    return EvaluationContext::current().isInstantiated(slot); 
 	}
     /** Setter for the index.
         @todo should this be private?
         @todo should this assert "instatiated"?
     */
 	void assign(int i) { 
-	    index = i;
+	    EvaluationContext::current().assign(slot,i);
 	}
     /** unsetter for instatiated.
         @todo should this be private?
     */
 	void unInstantiate() {
-	    instantiated = false; 
+	    EvaluationContext::current().setInstantiated(slot,false); 
 	}
     /** setter for instatiated.
         @todo should this be private?
     */
 	void instantiate() {
-	    instantiated = true; 
+	    EvaluationContext::current().setInstantiated(slot,true); 
 	}
     /** getter for MP_index * data type.  
         @todo should this be private?
@@ -89,6 +211,15 @@ namespace flopc {
 	MP_index* getIndex() const {
 	    return const_cast<MP_index*>(this);
 	}
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    s.insert(this);
+	    return true;
+	}
+	bool getAffine(const MP_index*& index, int& shift) const {
+	    index = this;
+	    shift = 0;
+	    return true;
+	}
     /// Getter for domain over which this index is applied.
 	virtual MP_domain getDomain(MP_set* s) const;
     /** @todo should this be private?
@@ -99,9 +230,12 @@ namespace flopc {
 	static MP_index &getEmpty();
 
     private:
+	static int newSlot();
+	static void releaseSlot(int s);
 	static MP_index& Empty;
-	int index;
-	bool instantiated;
+	static int nextSlot;
+	/// position of this index' binding in an EvaluationContext
+	int slot;
     };
 
 
@@ -183,6 +317,9 @@ namespace flopc {
 	    return left->getIndex();
 	}
 	virtual MP_domain getDomain(MP_set* s) const;
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
 	MP_index_exp left;
 	Constant right;
     };
@@ -206,6 +343,18 @@ namespace flopc {
 	    return left->getIndex();
 	}
 	virtual MP_domain getDomain(MP_set* s) const;
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
+	bool getAffine(const MP_index*& index, int& shift) const {
+	    std::set<const MP_index*> s;
+	    if (left->getAffine(index,shift) == false ||
+		right->insertIndices(s) == false || s.empty() == false) {
+		return false;
+	    }
+	    shift += int(right->evaluate());
+	    return true;
+	}
 	MP_index_exp left;
 	Constant right;
     };
@@ -229,6 +378,18 @@ namespace flopc {
 	    return left->getIndex();
 	}
 	virtual MP_domain getDomain(MP_set* s) const;
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    return left->insertIndices(s) && right->insertIndices(s);
+	}
+	bool getAffine(const MP_index*& index, int& shift) const {
+	    std::set<const MP_index*> s;
+	    if (left->getAffine(index,shift) == false ||
+		right->insertIndices(s) == false || s.empty() == false) {
+		return false;
+	    }
+	    shift -= int(right->evaluate());
+	    return true;
+	}
 	MP_index_exp left;
 	Constant right;
     };
@@ -0,0 +1,290 @@
+// ******************** FlopCpp **********************************************
+// File: MP_loader.cpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+//****************************************************************************
+
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <CoinError.hpp>
+#include <CoinTime.hpp>
+#include "MP_loader.hpp"
+
+using namespace flopc;
+using namespace std;
+
+namespace {
+    unsigned int hashLabel(const char* label, size_t length) {
+	unsigned int h = 2166136261u;
+	for (size_t k=0; k<length; k++) {
+	    h = (h ^ static_cast<unsigned char>(label[k]))*16777619u;
+	}
+	return h;
+    }
+
+    bool isBlank(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    /** @brief Parses the rows of one chunk of a file, interning the
+        labels in tables of its own.
+    */
+    class ChunkParser : public Functor {
+    public:
+	ChunkParser(const char* b, const char* e, char d, int w, bool v,
+		    SymbolTable* const* t) :
+	    local(w), skipped(0), begin(b), end(e), delimiter(d), width(w),
+	    withValue(v), tables(t) {}
+	void operator()() const {
+	    const char* line = begin;
+	    while (line < end) {
+		const char* next = std::find(line,end,'\n');
+		parseLine(line,next);
+		line = next+1;
+	    }
+	}
+	/// the positions of the indices, with labels numbered as in local
+	mutable vector<int> positions;
+	mutable vector<double> values;
+	mutable vector<SymbolTable> local;
+	mutable int skipped;
+    private:
+	/// parses the line from b to e, unless it is empty.
+	void parseLine(const char* b, const char* e) const {
+	    const int fields = width + (withValue == true ? 1 : 0);
+	    const char* first[7];
+	    const char* last[7];
+	    int n = 0;
+	    for (const char* f = b; n <= fields; f++) {
+		first[n] = f;
+		f = std::find(f,e,delimiter);
+		last[n] = f;
+		trim(first[n],last[n]);
+		n++;
+		if (f == e) {
+		    break;
+		}
+	    }
+	    if (n == 1 && first[0] == last[0]) {
+		return;
+	    }
+	    // Labels are interned only once the row is known to be valid.
+	    int p[5];
+	    double v = 0;
+	    // Subsets ignore the fields after the indices.
+	    bool ok = (n == fields || (withValue == false && n > fields));
+	    for (int j=0; ok == true && j<fields; j++) {
+		char* stop;
+		if (first[j] == last[j]) {
+		    ok = false;
+		} else if (j == width) {
+		    // The text ends with a 0, so the numbers end within it.
+		    v = strtod(first[j],&stop);
+		    ok = (stop == last[j]);
+		} else if (tables[j] == 0) {
+		    p[j] = static_cast<int>(strtol(first[j],&stop,10));
+		    ok = (stop == last[j]);
+		}
+	    }
+	    if (ok == false) {
+		skipped++;
+		return;
+	    }
+	    for (int j=0; j<width; j++) {
+		if (tables[j] != 0) {
+		    p[j] = local[j].intern(first[j],last[j]-first[j]);
+		}
+		positions.push_back(p[j]);
+	    }
+	    if (withValue == true) {
+		values.push_back(v);
+	    }
+	}
+	/// removes blanks and double quotes around the field from b to e.
+	static void trim(const char*& b, const char*& e) {
+	    while (b < e && isBlank(*b) == true) {
+		b++;
+	    }
+	    while (e > b && isBlank(e[-1]) == true) {
+		e--;
+	    }
+	    if (e-b >= 2 && *b == '"' && e[-1] == '"') {
+		b++;
+		e--;
+	    }
+	}
+	const char* begin;
+	const char* end;
+	char delimiter;
+	int width;
+	bool withValue;
+	SymbolTable* const* tables;
+    };
+}
+
+int SymbolTable::find(const char* label, size_t length, unsigned int h) const {
+    const size_t mask = table.size()-1;
+    for (size_t k=h & mask; table[k] >= 0; k = (k+1) & mask) {
+	const string& l = labels[table[k]];
+	if (hashes[table[k]] == h && l.size() == length &&
+	    std::equal(label,label+length,l.begin()) == true) {
+	    return table[k];
+	}
+    }
+    return outOfBound;
+}
+
+int SymbolTable::find(const string& label) const {
+    return find(label.data(),label.size(),hashLabel(label.data(),label.size()));
+}
+
+void SymbolTable::place(int position) {
+    const size_t mask = table.size()-1;
+    size_t k = hashes[position] & mask;
+    while (table[k] >= 0) {
+	k = (k+1) & mask;
+    }
+    table[k] = position;
+}
+
+int SymbolTable::intern(const char* label, size_t length) {
+    const unsigned int h = hashLabel(label,length);
+    const int p = find(label,length,h);
+    if (p != outOfBound) {
+	return p;
+    }
+    labels.push_back(string(label,length));
+    hashes.push_back(h);
+    const int n = size();
+    if (2*static_cast<size_t>(n) > table.size()) {
+	table.assign(2*table.size(),-1);
+	for (int k=0; k<n; k++) {
+	    place(k);
+	}
+    } else {
+	place(n-1);
+    }
+    return n-1;
+}
+
+double DataLoader::parse(const string& file, int width, bool withValue,
+			 SymbolTable* const* tables,
+			 vector<int>& positions, vector<double>& values) {
+    const double start = CoinWallclockTime();
+    rows = 0;
+    skipped = 0;
+    FILE* f = fopen(file.c_str(),"rb");
+    if (f == 0) {
+	throw CoinError("cannot open file", "load", "DataLoader");
+    }
+    vector<char> text;
+    char buffer[1<<16];
+    size_t n;
+    while ((n = fread(buffer,1,sizeof(buffer),f)) > 0) {
+	text.insert(text.end(),buffer,buffer+n);
+    }
+    fclose(f);
+    text.push_back(0);
+    const char* begin = &text[0];
+    const char* end = begin+text.size()-1;
+
+    char d = delimiter;
+    if (d == 0) {
+	const char* eol = std::find(begin,end,'\n');
+	d = std::find(begin,eol,'\t') != eol ? '\t' : ',';
+    }
+    if (header == true) {
+	begin = std::min(end,std::find(begin,end,'\n')+1);
+    }
+
+    // Chunks of whole lines, a few for each thread to even out the load.
+    vector<ChunkParser*> parsers;
+    vector<const Functor*> tasks;
+    const size_t step = (end-begin)/(4*max(nThreads,1))+1;
+    for (const char* b = begin; b < end; ) {
+	const char* e = b+std::min(step,static_cast<size_t>(end-b));
+	e = std::min(end,std::find(e,end,'\n')+1);
+	parsers.push_back(new ChunkParser(b,e,d,width,withValue,tables));
+	tasks.push_back(parsers.back());
+	b = e;
+    }
+    WorkerPool pool(nThreads);
+    pool.run(tasks);
+
+    // Intern the labels chunk by chunk, so in the order of the file.
+    for (size_t k=0; k<parsers.size(); k++) {
+	const ChunkParser& p = *parsers[k];
+	vector<vector<int> > global(width);
+	for (int j=0; j<width; j++) {
+	    if (tables[j] != 0) {
+		for (int l=0; l<p.local[j].size(); l++) {
+		    global[j].push_back(tables[j]->intern(p.local[j].label(l)));
+		}
+	    }
+	}
+	for (size_t r=0; r<p.positions.size(); r++) {
+	    const int j = static_cast<int>(r % width);
+	    positions.push_back(tables[j] != 0 ? global[j][p.positions[r]] :
+				p.positions[r]);
+	}
+	values.insert(values.end(),p.values.begin(),p.values.end());
+	skipped += p.skipped;
+	delete parsers[k];
+    }
+    rows = static_cast<int>(withValue == true ? values.size() :
+			    positions.size()/max(width,1));
+    return start;
+}
+
+void DataLoader::finish(const string& file, double start) {
+    seconds = CoinWallclockTime()-start;
+    if (skipped > 0) {
+	cout<<"FlopCpp Warning: "<<skipped<<" rows of "<<file
+	    <<" skipped."<<endl;
+    }
+}
+
+void DataLoader::load(const string& file, MP_data& d,
+		      SymbolTable* t1, SymbolTable* t2, SymbolTable* t3,
+		      SymbolTable* t4, SymbolTable* t5) {
+    SymbolTable* const tables[5] = {t1,t2,t3,t4,t5};
+    const MP_set_base* S[5] = {&d.S1,&d.S2,&d.S3,&d.S4,&d.S5};
+    int width = 0;
+    for (int j=0; j<5; j++) {
+	if (S[j] != &MP_set::getEmpty()) {
+	    width = j+1;
+	}
+    }
+    vector<int> positions;
+    vector<double> values;
+    const double start = parse(file,width,true,tables,positions,values);
+    int i[5] = {0,0,0,0,0};
+    for (size_t r=0; r<values.size(); r++) {
+	bool inside = true;
+	// Not check(), which wraps positions outside cyclic sets.
+	for (int j=0; j<width; j++) {
+	    i[j] = positions[r*width+j];
+	    if (i[j] < 0 || i[j] >= S[j]->size()) {
+		inside = false;
+	    }
+	}
+	if (inside == true) {
+	    d.set(i[0],i[1],i[2],i[3],i[4],values[r]);
+	} else {
+	    rows--;
+	    skipped++;
+	}
+    }
+    d.version++;
+    finish(file,start);
+}
+
+void DataLoader::report() const {
+    cout<<"FlopCpp: Rows loaded: "<<rows<<" in "<<seconds<<" s ("
+	<<(seconds > 0 ? rows/seconds : 0.0)<<" rows/s)"<<endl;
+}
@@ -0,0 +1,148 @@
+// ******************** FlopCpp **********************************************
+// File: MP_loader.hpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+// ****************************************************************************
+
+#ifndef _MP_loader_hpp_
+#define _MP_loader_hpp_
+
+#include <string>
+#include <vector>
+
+#include "MP_set.hpp"
+#include "MP_data.hpp"
+#include "MP_parallel.hpp"
+
+namespace flopc {
+
+    /** @brief Labels interned as the positions of a set.
+        @ingroup PublicInterface
+        Every distinct label is stored once, and stands for the position
+        given by the order in which it was first interned.
+    */
+    class SymbolTable {
+    public:
+	SymbolTable() : table(16,-1) {}
+	/// returns the position of label, appending it if new.
+	int intern(const std::string& label) {
+	    return intern(label.data(),label.size());
+	}
+	int intern(const char* label, size_t length);
+	/// returns the position of label, or outOfBound.
+	int find(const std::string& label) const;
+	const std::string& label(int position) const {
+	    return labels[position];
+	}
+	int size() const {
+	    return static_cast<int>(labels.size());
+	}
+    private:
+	int find(const char* label, size_t length, unsigned int h) const;
+	void place(int position);
+	std::vector<std::string> labels;
+	std::vector<unsigned int> hashes;
+	/// open addressing table of the positions, -1 for an empty slot
+	std::vector<int> table;
+    };
+
+    /** @brief Loads MP_data values and MP_subset elements from delimited
+        text files, such as CSV or TSV files.
+        @ingroup PublicInterface
+        Each line holds a row of fields separated by the delimiter: the
+        indices, one for each set, followed for data by the value.  An
+        index is a label, mapped to its position through the SymbolTable
+        given for its set, which interns new labels, or a position if no
+        table is given.  Blanks and double quotes around a field are
+        ignored, as are empty lines, and for subsets the fields after the
+        indices.
+        <br> The file is split into chunks parsed in parallel, after which
+        the labels are interned and the rows stored in file order, so the
+        result does not depend on the number of threads.  Rows which
+        cannot be parsed, or whose positions are outside the sets, cyclic
+        or not, are skipped with a warning.
+    */
+    class DataLoader {
+    public:
+	DataLoader(int threads = WorkerPool::hardwareThreads()) :
+	    nThreads(threads), delimiter(0), header(false), rows(0),
+	    skipped(0), seconds(0) {}
+	/** sets the delimiter of the fields.  By default it is a tab if the
+	    first line has one, and a comma otherwise.
+	*/
+	void setDelimiter(char d) {
+	    delimiter = d;
+	}
+	/// if h is true, the first line is a header, and is skipped.
+	void setHeader(bool h) {
+	    header = h;
+	}
+	/// loads the values of d.
+	void load(const std::string& file, MP_data& d,
+		  SymbolTable* t1 = 0, SymbolTable* t2 = 0,
+		  SymbolTable* t3 = 0, SymbolTable* t4 = 0,
+		  SymbolTable* t5 = 0);
+	/// loads elements of s, inserting them.
+	template<int nbr> void load(const std::string& file, MP_subset<nbr>& s,
+				    SymbolTable* t1 = 0, SymbolTable* t2 = 0,
+				    SymbolTable* t3 = 0, SymbolTable* t4 = 0,
+				    SymbolTable* t5 = 0) {
+	    SymbolTable* const tables[5] = {t1,t2,t3,t4,t5};
+	    std::vector<int> positions;
+	    std::vector<double> values;
+	    const double start = parse(file,nbr,false,tables,positions,values);
+	    std::vector<int> e(nbr);
+	    for (size_t r=0; r<positions.size(); r += nbr) {
+		bool inside = true;
+		for (int j=0; j<nbr; j++) {
+		    e[j] = positions[r+j];
+		    if (e[j] < 0 || e[j] >= s.S[j]->size()) {
+			inside = false;
+		    }
+		}
+		if (inside == true) {
+		    s.insert(e);
+		} else {
+		    rows--;
+		    skipped++;
+		}
+	    }
+	    finish(file,start);
+	}
+	/// returns the number of rows stored by the last load.
+	int getRows() const {
+	    return rows;
+	}
+	/// returns the number of rows skipped by the last load.
+	int getSkipped() const {
+	    return skipped;
+	}
+	/// returns the wall clock seconds the last load took.
+	double getSeconds() const {
+	    return seconds;
+	}
+	/// prints the rows stored by the last load and their throughput.
+	void report() const;
+    private:
+	/** parses the rows of file, of width indices and, if withValue, a
+	    value.  Appends the positions of the indices of the rows parsed,
+	    width of them each, and their values, and returns the wall clock
+	    time it started.
+	*/
+	double parse(const std::string& file, int width, bool withValue,
+		     SymbolTable* const* tables,
+		     std::vector<int>& positions, std::vector<double>& values);
+	/// records the time since start, warning of the rows skipped.
+	void finish(const std::string& file, double start);
+	int nThreads;
+	char delimiter;
+	bool header;
+	int rows;
+	int skipped;
+	double seconds;
+    };
+
+} // End of namespace flopc
+#endif
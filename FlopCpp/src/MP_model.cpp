@@ -7,14 +7,18 @@
 //****************************************************************************
 
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <algorithm>
 
 #include <CoinPackedMatrix.hpp>
+#include <CoinWarmStartBasis.hpp>
 #include <OsiSolverInterface.hpp>
 #include "MP_model.hpp"
 #include "MP_variable.hpp"
 #include "MP_constraint.hpp"
+#include "MP_parallel.hpp"
+#include "MP_spill.hpp"
 #include <CoinTime.hpp>
 
 using namespace flopc;
@@ -58,10 +62,45 @@ void VerboseMessenger::objectiveDebug(const vector<Coef>& cfs) {
     }
 }
 
+namespace {
+    bool slower(const GenerationProfile& a, const GenerationProfile& b) {
+	return a.wallTime > b.wallTime;
+    }
+}
+
+void ProfilingMessenger::generationProfile(const GenerationProfile& p) {
+    if (complete == true) {
+	profiles.clear();
+	complete = false;
+    }
+    profiles.push_back(p);
+}
+
+void ProfilingMessenger::generationTime(double t) {
+    NormalMessenger::generationTime(t);
+    vector<GenerationProfile> sorted(profiles);
+    stable_sort(sorted.begin(),sorted.end(),slower);
+    cout<<"FlopCpp: Block  wall  cpu  tuples  coefficients  nonzeros  "
+	<<"buffer growth"<<endl;
+    for (size_t k=0; k<sorted.size(); k++) {
+	const GenerationProfile& p = sorted[k];
+	cout<<"FlopCpp: "<<(p.objective ? string("Objective") : 
+			    p.name.empty() ? string("(unnamed)") : p.name)
+	    <<"  "<<p.wallTime<<"  "<<p.cpuTime<<"  "<<p.tuples
+	    <<"  "<<p.coefficients<<"  "<<p.nonzeros<<"  "<<p.bufferGrowth
+	    <<endl;
+    }
+    complete = true;
+}
+
 MP_model::MP_model(OsiSolverInterface* s, Messenger* m) : 
     solution(0), messenger(m), Objective(0), Solver(s), 
     m(0), n(0), nz(0), bl(0),
-    mSolverState(((s==NULL)?(MP_model::DETACHED):(MP_model::SOLVER_ONLY))) {
+    mSolverState(((s==NULL)?(MP_model::DETACHED):(MP_model::SOLVER_ONLY))),
+    generationThreads(1), generation(TRIPLETS), 
+    generationMemory(256*1024*1024), compiledGeneration(false),
+    compiledCheck(false), incrementalAttach(false), loadedSolver(0),
+    keepBasis(false), warmStart(false) {
     MP_model::current_model = this;
 }
 
@@ -87,12 +126,13 @@ double MP_model::getInfinity() const {
 void MP_model::add(MP_variable* v) {
     v->M = this;
     v->offset = n;
+    v->added.clear();
     n += v->size();
 }
 
 void MP_model::addRow(const Constraint& lcl_c) {
     vector<Coef> cfs;
-    vector<Constant> v;
+    MultiplicatorStack v;
     ObjectiveGenerateFunctor f(cfs);
     lcl_c.left->generate(MP_domain::getEmpty(),v,f,1.0);
     lcl_c.right->generate(MP_domain::getEmpty(),v,f,-1.0);
@@ -130,6 +170,182 @@ void MP_model::addRow(const Constraint& lcl_c) {
     Solver->addRow(newRow,lcl_bl,lcl_bu);
 }
 
+void MP_model::addRows(MP_constraint& lcl_c) {
+    if (Solver == 0 || mSolverState == MP_model::DETACHED ||
+	mSolverState == MP_model::SOLVER_ONLY) {
+	add(lcl_c);
+	return;
+    }
+    set<MP_variable*> vars;
+    lcl_c.insertVariables(vars);
+    for (varIt j=vars.begin(); j!=vars.end(); j++) {
+	if (Variables.count(*j) == 0) {
+	    cout<<"FlopCpp Warning: Constraint "<<lcl_c.getName()
+		<<" uses variables which are not attached, it is not added."
+		<<endl;
+	    return;
+	}
+    }
+    add(lcl_c);
+    m = Solver->getNumRows();
+    add(&lcl_c);
+
+    CoefBuffer cfs;
+    CoefBuffer coefs;
+    generateBlock(&lcl_c,cfs,coefs);
+
+    // The rows in row order, and the right hand side.
+    const int begin = lcl_c.offset;
+    const int size = lcl_c.size();
+    vector<CoinBigIndex> start(size+1,0);
+    vector<double> rhs(size,0.0);
+    for (size_t k=0; k<coefs.size(); k++) {
+	if (coefs.col(k) == -1) {
+	    rhs[coefs.row(k)-begin] = -coefs.val(k);
+	} else {
+	    start[coefs.row(k)-begin+1]++;
+	}
+    }
+    for (int r=0; r<size; r++) {
+	start[r+1] += start[r];
+    }
+    vector<int> cols(start[size]);
+    vector<double> vals(start[size]);
+    vector<CoinBigIndex> fill(start.begin(),start.end()-1);
+    for (size_t k=0; k<coefs.size(); k++) {
+	if (coefs.col(k) != -1) {
+	    const int r = coefs.row(k)-begin;
+	    cols[fill[r]] = coefs.col(k);
+	    vals[fill[r]] = coefs.val(k);
+	    fill[r]++;
+	}
+    }
+
+    // Row bounds, as in attach().
+    const double inf = Solver->getInfinity();
+    vector<double> lower(rhs);
+    vector<double> upper(rhs);
+    for (int r=0; r<size; r++) {
+	if (lcl_c.sense == LE) {
+	    lower[r] = -inf;
+	} else if (lcl_c.sense == GE) {
+	    upper[r] = inf;
+	}
+    }
+    if (size > 0) {
+	Solver->addRows(size,&start[0],cols.empty() ? 0 : &cols[0],
+			vals.empty() ? 0 : &vals[0],&lower[0],&upper[0]);
+    }
+
+    if (incrementalAttach == true && loadedSolver == Solver) {
+	LoadedRows r;
+	r.constraint = &lcl_c;
+	r.offset = begin;
+	r.size = size;
+	r.version = lcl_c.version;
+	r.reads = lcl_c.reads;
+	loadedRows.push_back(r);
+    }
+    if (mSolverState != MP_model::ATTACHED) {
+	// The solver keeps its basis; the new rows are basic.
+	warmStart = true;
+    }
+}
+
+void MP_model::addColumns(MP_variable& v, int count) {
+    const int first = v.size();
+    const int active = v.getActive();
+    v.setActive(active+count);
+    const int last = v.size();
+    if (Solver == 0 || mSolverState == MP_model::DETACHED ||
+	mSolverState == MP_model::SOLVER_ONLY || v.offset < 0 ||
+	Variables.count(&v) == 0 || last == first) {
+	return;
+    }
+    const int begin = Solver->getNumCols();
+    const int size = last-first;
+    v.added.push_back(make_pair(first,begin));
+
+    // The coefficients of the new columns in the loaded rows.  Only the
+    // terms of v are generated, and only for the new elements.
+    v.firstGenerated = active;
+    const int rows = Solver->getNumRows();
+    CoefBuffer cfs;
+    CoefBuffer coefs;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+	if ((*i)->offset < 0 || (*i)->offset+(*i)->size() > rows) {
+	    continue;
+	}
+	set<MP_variable*> vars;
+	(*i)->insertVariables(vars);
+	if (vars.count(&v) == 0) {
+	    continue;
+	}
+	GenerateFunctor f(cfs);
+	f.only = &v;
+	(*i)->coefficients(f);
+    }
+    assemble(cfs,coefs);
+
+    vector<CoinBigIndex> start(size+1,0);
+    vector<int> rowIndex(coefs.size());
+    vector<double> elements(coefs.size());
+    for (size_t k=0; k<coefs.size(); k++) {
+	start[coefs.col(k)-begin+1]++;
+	rowIndex[k] = coefs.row(k);
+	elements[k] = coefs.val(k);
+    }
+    for (int j=0; j<size; j++) {
+	start[j+1] += start[j];
+    }
+
+    // Objective function coefficients
+    vector<double> obj(size,0.0);
+    {
+	CoefBuffer objective;
+	CoefBuffer assembled;
+	MultiplicatorStack mults;
+	ObjectiveGenerateFunctor f(objective);
+	f.only = &v;
+	Objective->generate(MP_domain::getEmpty(), mults, f, 1.0);
+	assemble(objective,assembled);
+	for (size_t k=0; k<assembled.size(); k++) {
+	    if (assembled.col(k) < begin) {
+		continue;
+	    }
+	    obj[assembled.col(k)-begin] = assembled.val(k);
+	}
+    }
+    v.firstGenerated = 0;
+
+    // Column bounds
+    vector<double> lower(v.lowerLimit.v+first,v.lowerLimit.v+last);
+    vector<double> upper(v.upperLimit.v+first,v.upperLimit.v+last);
+
+    Solver->addCols(size,&start[0],rowIndex.empty() ? 0 : &rowIndex[0],
+		    elements.empty() ? 0 : &elements[0],&lower[0],&upper[0],
+		    &obj[0]);
+    if (v.type == discrete) {
+	for (int j=begin; j<begin+size; j++) {
+	    Solver->setInteger(j);
+	}
+    }
+    n = begin+size;
+
+    if (incrementalAttach == true && loadedSolver == Solver) {
+	for (size_t k=0; k<loadedColumns.size(); k++) {
+	    if (loadedColumns[k].variable == &v) {
+		loadedColumns[k].size = last;
+		loadedColumns[k].added = v.added;
+	    }
+	}
+    }
+    if (mSolverState != MP_model::ATTACHED) {
+	// The solver keeps its basis; the new columns are nonbasic.
+	warmStart = true;
+    }
+}
+
 void MP_model::setObjective(const MP_expression& o) { 
     Objective = o; 
 }
@@ -145,37 +361,608 @@ void MP_model::minimize_max(MP_set &s, const MP_expression  &obj) {
 
 class flopc::CoefLess {
 public:
-    bool operator() (const Coef& a, const Coef& b) const {
-	if (a.col < b.col) {
-	    return true;
-	} else if (a.col == b.col && a.row < b.row) {
-	    return true;
+    CoefLess(const CoefBuffer& b) : v(b) {}
+    /// orders positions in v by (col,row), then by position.
+    bool operator() (int a, int b) const {
+	if (v.col(a) != v.col(b)) {
+	    return v.col(a) < v.col(b);
+	} else if (v.row(a) != v.row(b)) {
+	    return v.row(a) < v.row(b);
 	} else {
-	    return false;
+	    return a < b;
 	}
     }
+private:
+    const CoefBuffer& v;
 };
 
-void MP_model::assemble(vector<Coef>& v, vector<Coef>& av) {
-    std::sort(v.begin(),v.end(),CoefLess());
-    int c,r,s;
-    double val;
-    std::vector<Coef>::const_iterator i = v.begin();
-    while (i!=v.end()) {
-	c = i->col;
-	r = i->row;
-	val = i->val;
-	s = i->stage;
-	i++;
-	while (i!=v.end() && c==i->col && r==i->row) {
-	    val += i->val;
-	    if (i->stage>s) {
-		s = i->stage;
+namespace {
+    struct RowKey {
+	int operator()(const CoefBuffer& v, int k) const {
+	    return v.row(k);
+	}
+    };
+    struct ColKey {
+	int operator()(const CoefBuffer& v, int k) const {
+	    return v.col(k);
+	}
+    };
+
+    /** Stable counting sort of the positions in by their key in v, whose
+        values lie in [lo,lo+n).  Runs in O(in.size()+n).
+    */
+    template <class Key>
+    void bucketSort(const CoefBuffer& v, const vector<int>& in, 
+		    vector<int>& out, Key key, int lo, size_t n) {
+	vector<size_t> start(n+1,0);
+	for (size_t k=0; k<in.size(); k++) {
+	    start[key(v,in[k])-lo+1]++;
+	}
+	for (size_t b=0; b<n; b++) {
+	    start[b+1] += start[b];
+	}
+	out.resize(in.size());
+	for (size_t k=0; k<in.size(); k++) {
+	    out[start[key(v,in[k])-lo]++] = in[k];
+	}
+    }
+}
+
+void MP_model::sortCoefficients(const CoefBuffer& v, vector<int>& order) {
+    const int size = static_cast<int>(v.size());
+    order.resize(size);
+    if (size == 0) {
+	return;
+    }
+    int cmin = v.col(0), cmax = v.col(0);
+    int rmin = v.row(0), rmax = v.row(0);
+    for (int k=1; k<size; k++) {
+	cmin = std::min(cmin,v.col(k));
+	cmax = std::max(cmax,v.col(k));
+	rmin = std::min(rmin,v.row(k));
+	rmax = std::max(rmax,v.row(k));
+    }
+    const size_t nc = static_cast<size_t>(cmax-cmin)+1;
+    const size_t nr = static_cast<size_t>(rmax-rmin)+1;
+    for (int k=0; k<size; k++) {
+	order[k] = k;
+    }
+    if (nc+nr <= 4*v.size()) {
+	// Sort by row, then (stably) by column, in linear time.
+	vector<int> byRow;
+	bucketSort(v,order,byRow,RowKey(),rmin,nr);
+	bucketSort(v,byRow,order,ColKey(),cmin,nc);
+    } else {
+	// Few coefficients spread over many columns, where the counting
+	// arrays would cost more than the sort.
+	std::sort(order.begin(),order.end(),CoefLess(v));
+    }
+}
+
+void MP_model::assemble(CoefBuffer& v, CoefBuffer& av) {
+    const int size = static_cast<int>(v.size());
+    vector<int> order;
+    sortCoefficients(v,order);
+    // Duplicates are summed in generation order; the highest stage wins.
+    int k = 0;
+    while (k<size) {
+	const int c = v.col(order[k]);
+	const int r = v.row(order[k]);
+	double val = v.val(order[k]);
+	int s = v.stage(order[k]);
+	k++;
+	while (k<size && c==v.col(order[k]) && r==v.row(order[k])) {
+	    val += v.val(order[k]);
+	    if (v.stage(order[k])>s) {
+		s = v.stage(order[k]);
+	    }
+	    k++;
+	}
+	av.push_back(c,r,val,s);
+    }
+}
+
+void MP_model::constraintDebug(const MP_constraint* c, const CoefBuffer& cfs) {
+    if (messenger->debugCoefficients() == true) {
+	vector<Coef> raw;
+	cfs.copy(raw);
+	messenger->constraintDebug(c->getName(),raw);
+    }
+}
+
+namespace flopc {
+    /** Measures what is generated with a GenerateFunctor, and merged into
+        coefs, from its construction on, for Messenger::generationProfile().
+        Does nothing unless on.
+    */
+    class BlockProfiler {
+    public:
+	BlockProfiler(bool on, const GenerateFunctor& f, 
+		      const CoefBuffer* cfs = 0, const CoefBuffer* coefs = 0) :
+	    On(on), F(f), Cfs(cfs), Coefs(coefs), 
+	    tuples(f.tuples), stored(f.stored), 
+	    size(coefs ? coefs->size() : 0), bytes(buffered()),
+	    wall(on ? CoinWallclockTime() : 0.0), 
+	    cpu(on ? WorkerPool::threadCpuTime() : 0.0) {}
+	/// adds the time since construction to p.
+	void stopTime(GenerationProfile& p) const {
+	    if (On == true) {
+		p.wallTime += CoinWallclockTime()-wall;
+		p.cpuTime += WorkerPool::threadCpuTime()-cpu;
+	    }
+	}
+	/// adds the time, and what was generated since construction, to p.
+	void stop(GenerationProfile& p) const {
+	    if (On == true) {
+		stopTime(p);
+		p.tuples += F.tuples-tuples;
+		p.coefficients += F.stored-stored;
+		p.nonzeros += (Coefs ? Coefs->size() : 0)-size;
+		p.bufferGrowth += buffered()-bytes;
+	    }
+	}
+    private:
+	size_t buffered() const {
+	    return (Cfs ? Cfs->bytes() : 0)+(Coefs ? Coefs->bytes() : 0);
+	}
+	bool On;
+	const GenerateFunctor& F;
+	const CoefBuffer* Cfs;
+	const CoefBuffer* Coefs;
+	size_t tuples;
+	size_t stored;
+	size_t size;
+	size_t bytes;
+	double wall;
+	double cpu;
+    };
+
+    /** Task generating and assembling one constraint block into buffers
+        of its own.  Used by MP_model::generateParallel().
+    */
+    class GenerateBlock : public Functor {
+    public:
+	GenerateBlock(MP_constraint* c, bool p) : C(c), profiling(p) {
+	    profile.name = c->getName();
+	}
+	void operator()() const {
+	    GenerateFunctor f(cfs);
+	    BlockProfiler profiler(profiling,f,&cfs,&coefs);
+	    C->coefficients(f);
+	    MP_model::assemble(cfs,coefs);
+	    profiler.stop(profile);
+	}
+	MP_constraint* C;
+	bool profiling;
+	mutable CoefBuffer cfs;
+	mutable CoefBuffer coefs;
+	mutable GenerationProfile profile;
+    };
+}
+
+void MP_model::generateBlock(MP_constraint* c, CoefBuffer& cfs, 
+			     CoefBuffer& coefs) {
+    GenerateFunctor f(cfs);
+    BlockProfiler profiler(messenger->profiling(),f,&cfs,&coefs);
+    c->coefficients(f);
+    constraintDebug(c,cfs);
+    assemble(cfs,coefs);
+    if (messenger->profiling() == true) {
+	GenerationProfile profile;
+	profile.name = c->getName();
+	profiler.stop(profile);
+	messenger->generationProfile(profile);
+    }
+    cfs.clear();
+}
+
+void MP_model::generateParallel(CoefBuffer& coefs) {
+    vector<GenerateBlock*> blocks;
+    vector<const Functor*> tasks;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+	blocks.push_back(new GenerateBlock(*i,messenger->profiling()));
+	tasks.push_back(blocks.back());
+    }
+
+    WorkerPool pool(generationThreads);
+    pool.run(tasks);
+
+    // Merge in block order, so the result does not depend on scheduling.
+    size_t nz = 0;
+    for (size_t k=0; k<blocks.size(); k++) {
+	nz += blocks[k]->coefs.size();
+    }
+    coefs.reserve(coefs.size()+nz);
+    for (size_t k=0; k<blocks.size(); k++) {
+	constraintDebug(blocks[k]->C,blocks[k]->cfs);
+	if (messenger->profiling() == true) {
+	    messenger->generationProfile(blocks[k]->profile);
+	}
+	coefs.append(blocks[k]->coefs);
+	delete blocks[k];
+    }
+}
+
+namespace flopc {
+    /** Counts the coefficients of every column, with the right hand side
+        as column n.  First pass of MP_model::generateColumns().
+    */
+    class ColumnCountFunctor : public GenerateFunctor {
+    public:
+	ColumnCountFunctor(vector<Coef>& unused, int* clg, int n) : 
+	    GenerateFunctor(unused), Clg(clg), N(n) {}
+	void store(const Coef& c) const {
+	    Clg[c.col == -1 ? N : c.col]++;
+	}
+	int* Clg;
+	int N;
+    };
+
+    /** Scatters the coefficients into the column ordered arrays counted
+        by ColumnCountFunctor.  Second pass of MP_model::generateColumns().
+    */
+    class ColumnScatterFunctor : public GenerateFunctor {
+    public:
+	ColumnScatterFunctor(vector<Coef>& unused, double* elm, int* rnr,
+			     const int* cst, int* clg, int n) : 
+	    GenerateFunctor(unused), Elm(elm), Rnr(rnr), Cst(cst), Clg(clg), 
+	    N(n) {}
+	void store(const Coef& c) const {
+	    const int col = (c.col == -1) ? N : c.col;
+	    const int k = Cst[col]+Clg[col]++;
+	    Elm[k] = c.val;
+	    Rnr[k] = c.row;
+	}
+	double* Elm;
+	int* Rnr;
+	const int* Cst;
+	int* Clg;
+	int N;
+    };
+}
+
+void MP_model::generateColumns() {
+    const bool profiling = messenger->profiling();
+    vector<GenerationProfile> profiles(Constraints.size());
+    vector<Coef> unused;
+    Clg = new int[n+1];
+    for (int j=0; j<=n; j++) {
+	Clg[j] = 0;
+    }
+    ColumnCountFunctor count(unused,Clg,n);
+    size_t b = 0;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++, b++) {
+	BlockProfiler profiler(profiling,count);
+	(*i)->coefficients(count);
+	profiler.stop(profiles[b]);
+    }
+    Cst = new int[n+2];
+    Cst[0] = 0;
+    for (int j=0; j<=n; j++) {
+	Cst[j+1] = Cst[j]+Clg[j];
+	Clg[j] = 0;
+    }
+    Elm = new double[Cst[n+1]];
+    Rnr = new int[Cst[n+1]];
+    ColumnScatterFunctor scatter(unused,Elm,Rnr,Cst,Clg,n);
+    b = 0;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++, b++) {
+	BlockProfiler profiler(profiling,scatter);
+	(*i)->coefficients(scatter);
+	profiler.stopTime(profiles[b]);
+    }
+
+    // Merge duplicate rows in place, summing in generation order, and
+    // order every column by row.  where[r] is the position of row r in
+    // the column being merged, if it is not smaller than that column's
+    // start.
+    vector<int> where(m,-1);
+    vector<pair<int,double> > column;
+    int k = 0;
+    for (int j=0; j<=n; j++) {
+	const int begin = k;
+	const int end = Cst[j+1];
+	bool sorted = true;
+	for (int p=Cst[j]; p<end; p++) {
+	    const int r = Rnr[p];
+	    if (where[r] >= begin) {
+		Elm[where[r]] += Elm[p];
+	    } else {
+		if (k > begin && Rnr[k-1] > r) {
+		    sorted = false;
+		}
+		where[r] = k;
+		Rnr[k] = r;
+		Elm[k] = Elm[p];
+		k++;
+	    }
+	}
+	if (sorted == false) {
+	    column.clear();
+	    for (int p=begin; p<k; p++) {
+		column.push_back(make_pair(Rnr[p],Elm[p]));
+	    }
+	    std::sort(column.begin(),column.end());
+	    for (int p=begin; p<k; p++) {
+		Rnr[p] = column[p-begin].first;
+		Elm[p] = column[p-begin].second;
+	    }
+	}
+	Cst[j] = begin;
+	Clg[j] = k-begin;
+    }
+    Cst[n+1] = k;
+    nz = k;
+
+    if (profiling == true) {
+	rowNonzeros(profiles);
+	for (size_t b=0; b<profiles.size(); b++) {
+	    messenger->generationProfile(profiles[b]);
+	}
+    }
+}
+
+void MP_model::rowNonzeros(vector<GenerationProfile>& profiles) const {
+    vector<size_t> rowNz(m,0);
+    for (int k=0; k<Cst[n+1]; k++) {
+	rowNz[Rnr[k]]++;
+    }
+    size_t b = 0;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++, b++) {
+	profiles[b].name = (*i)->getName();
+	for (int r=(*i)->offset; r<(*i)->offset+(*i)->size(); r++) {
+	    profiles[b].nonzeros += rowNz[r];
+	}
+    }
+}
+
+void MP_model::assignOffsets() {
+    m=0;
+    n=0;
+    Objective->insertVariables(Variables);
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+	add(*i);
+	(*i)->insertVariables(Variables);
+    }
+    for (varIt j=Variables.begin(); j!=Variables.end(); j++) {
+	add(*j);
+    }
+}
+
+namespace flopc {
+    /// Generates into a CoefSpill.
+    class SpillFunctor : public GenerateFunctor {
+    public:
+	SpillFunctor(vector<Coef>& unused, CoefSpill& s) : 
+	    GenerateFunctor(unused), S(s) {}
+	void store(const Coef& c) const {
+	    S.add(c);
+	}
+	CoefSpill& S;
+    };
+
+    /// Counts merged coefficients per column, rhs as column n.
+    class ColumnCountSink : public CoefSpill::Sink {
+    public:
+	ColumnCountSink(int* clg, int n) : Clg(clg), N(n) {}
+	void operator()(const Coef& c) {
+	    Clg[c.col == -1 ? N : c.col]++;
+	}
+	int* Clg;
+	int N;
+    };
+
+    /** Fills column ordered arrays from merged coefficients, which
+        arrive in column order with the rhs (column -1) first.
+    */
+    class ColumnFillSink : public CoefSpill::Sink {
+    public:
+	ColumnFillSink(double* elm, int* rnr, const int* cst, int* clg, 
+		       int n) : 
+	    Elm(elm), Rnr(rnr), Cst(cst), Clg(clg), N(n) {}
+	void operator()(const Coef& c) {
+	    const int col = (c.col == -1) ? N : c.col;
+	    const int k = Cst[col]+Clg[col]++;
+	    Elm[k] = c.val;
+	    Rnr[k] = c.row;
+	}
+	double* Elm;
+	int* Rnr;
+	const int* Cst;
+	int* Clg;
+	int N;
+    };
+}
+
+void MP_model::spillConstraints(CoefSpill& spill,
+				vector<GenerationProfile>& profiles) {
+    vector<Coef> unused;
+    SpillFunctor f(unused,spill);
+    profiles.assign(Constraints.size(),GenerationProfile());
+    size_t b = 0;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++, b++) {
+	BlockProfiler profiler(messenger->profiling(),f);
+	(*i)->coefficients(f);
+	profiler.stop(profiles[b]);
+    }
+    spill.flush();
+}
+
+void MP_model::generateStreaming() {
+    CoefSpill spill(generationMemory);
+    vector<GenerationProfile> profiles;
+    spillConstraints(spill,profiles);
+
+    Clg = new int[n+1];
+    for (int j=0; j<=n; j++) {
+	Clg[j] = 0;
+    }
+    ColumnCountSink count(Clg,n);
+    spill.merge(count);
+    Cst = new int[n+2];
+    Cst[0] = 0;
+    for (int j=0; j<=n; j++) {
+	Cst[j+1] = Cst[j]+Clg[j];
+	Clg[j] = 0;
+    }
+    nz = Cst[n+1];
+    Elm = new double[nz];
+    Rnr = new int[nz];
+    ColumnFillSink fill(Elm,Rnr,Cst,Clg,n);
+    spill.merge(fill);
+
+    if (messenger->profiling() == true) {
+	rowNonzeros(profiles);
+	for (size_t b=0; b<profiles.size(); b++) {
+	    messenger->generationProfile(profiles[b]);
+	}
+    }
+}
+
+namespace flopc {
+    /** Writes the COLUMNS section of an MPS file from merged coefficients.
+        The rhs (column -1) arrives first and is kept for the RHS section.
+        Every column gets its objective entry, so that columns without any
+        coefficients are declared as well.
+    */
+    class MpsColumnSink : public CoefSpill::Sink {
+    public:
+	MpsColumnSink(ostream& o, const vector<double>& obj, 
+		      const vector<bool>& integer, vector<double>& rhs) :
+	    os(o), c(obj), isInteger(integer), Rhs(rhs), next(0), 
+	    inMarker(false) {}
+	void operator()(const Coef& cf) {
+	    if (cf.col == -1) {
+		Rhs[cf.row] = -cf.val;
+		return;
+	    }
+	    while (next <= cf.col) {
+		startColumn(next++);
+	    }
+	    os<<"    C"<<cf.col<<"  R"<<cf.row<<"  "<<cf.val<<"\n";
+	}
+	/// declares the remaining columns and closes the integer markers.
+	void finish() {
+	    while (next < static_cast<int>(c.size())) {
+		startColumn(next++);
+	    }
+	    if (inMarker == true) {
+		os<<"    MARKER  'MARKER'  'INTEND'\n";
+	    }
+	}
+    private:
+	void startColumn(int j) {
+	    if (isInteger[j] != inMarker) {
+		os<<"    MARKER  'MARKER'  "<<
+		    (isInteger[j] ? "'INTORG'" : "'INTEND'")<<"\n";
+		inMarker = isInteger[j];
+	    }
+	    os<<"    C"<<j<<"  OBJ  "<<c[j]<<"\n";
+	}
+	ostream& os;
+	const vector<double>& c;
+	const vector<bool>& isInteger;
+	vector<double>& Rhs;
+	int next;
+	bool inMarker;
+    };
+}
+
+void MP_model::generateMps(const std::string& fileName) {
+    ofstream os(fileName.c_str());
+    if (!os) {
+	cout<<"FlopCpp: cannot open "<<fileName<<endl;
+	return;
+    }
+    os.precision(17);
+    assignOffsets();
+
+    CoefBuffer cfs;
+    CoefBuffer coefs;
+    MultiplicatorStack v;
+    ObjectiveGenerateFunctor f(cfs);
+    Objective->generate(MP_domain::getEmpty(), v, f, 1.0);
+    assemble(cfs,coefs);
+    vector<double> obj(n,0.0);
+    double objConstant = 0.0;
+    for (size_t i=0; i<coefs.size(); i++) {
+	if (coefs.col(i) < 0) {
+	    objConstant += coefs.val(i);
+	    continue;
+	}
+	obj[coefs.col(i)] = coefs.val(i);
+    }
+
+    vector<bool> isInteger(n,false);
+    for (varIt i=Variables.begin(); i!=Variables.end(); i++) {
+	if ((*i)->type == discrete) {
+	    for (int k=0; k<(*i)->size(); k++) {
+		isInteger[(*i)->offset+k] = true;
 	    }
-	    i++;
 	}
-	av.push_back(Coef(c,r,val,s));
     }
+
+    os<<"NAME  FlopCpp\n";
+    os<<"ROWS\n";
+    os<<" N  OBJ\n";
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+	const char* type = ((*i)->sense == LE) ? "L" : 
+	    ((*i)->sense == GE) ? "G" : "E";
+	for (int k=(*i)->offset; k<(*i)->offset+(*i)->size(); k++) {
+	    os<<" "<<type<<"  R"<<k<<"\n";
+	}
+    }
+
+    os<<"COLUMNS\n";
+    vector<double> rhs(m,0.0);
+    {
+	CoefSpill spill(generationMemory);
+	vector<GenerationProfile> profiles;
+	spillConstraints(spill,profiles);
+	MpsColumnSink columns(os,obj,isInteger,rhs);
+	spill.merge(columns);
+	columns.finish();
+    }
+
+    os<<"RHS\n";
+    // The right hand side of the objective row is minus its constant.
+    if (objConstant != 0.0) {
+	os<<"    RHS  OBJ  "<<-objConstant<<"\n";
+    }
+    for (int k=0; k<m; k++) {
+	if (rhs[k] != 0.0) {
+	    os<<"    RHS  R"<<k<<"  "<<rhs[k]<<"\n";
+	}
+    }
+
+    // Bounds beyond the solver's (or COIN's usual) infinity are free.
+    const double inf = std::min(getInfinity(), 1e30);
+    os<<"BOUNDS\n";
+    for (varIt i=Variables.begin(); i!=Variables.end(); i++) {
+	for (int k=0; k<(*i)->size(); k++) {
+	    const int j = (*i)->offset+k;
+	    const double lo = (*i)->lowerLimit.v[k];
+	    const double up = (*i)->upperLimit.v[k];
+	    if (lo == up) {
+		os<<" FX BND  C"<<j<<"  "<<lo<<"\n";
+		continue;
+	    }
+	    if (lo <= -inf) {
+		os<<" MI BND  C"<<j<<"\n";
+	    }
+	    if (up < inf) {
+		os<<" UP BND  C"<<j<<"  "<<up<<"\n";
+	    } else if (isInteger[j] == true) {
+		// Some readers take integer columns without bounds as binary.
+		os<<" PL BND  C"<<j<<"\n";
+	    }
+	    // Written after UP, as a negative UP may reset a zero lower bound.
+	    if (lo > -inf && (lo != 0.0 || up < 0.0)) {
+		os<<" LO BND  C"<<j<<"  "<<lo<<"\n";
+	    }
+	}
+    }
+    os<<"ENDATA\n";
 }
 
 void MP_model::maximize() {
@@ -228,48 +1015,79 @@ void MP_model::attach(OsiSolverInterface *_solver) {
         }
         Solver=_solver;
     }
+    if (incrementalAttach == true && Solver == loadedSolver &&
+	mSolverState != MP_model::DETACHED &&
+	mSolverState != MP_model::SOLVER_ONLY && reattach() == true) {
+	return;
+    }
+    loadedSolver = 0;
+    warmStart = false;
+
     double time = CoinCpuTime();
-    m=0;
-    n=0;
-    vector<Coef> coefs;
-    vector<Coef> cfs;
+    CoefBuffer coefs;
+    CoefBuffer cfs;
 
-    typedef std::set<MP_variable* >::iterator varIt;
-    typedef std::set<MP_constraint* >::iterator conIt;
-    
-    Objective->insertVariables(Variables);
-    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
-	add(*i);
-	(*i)->insertVariables(Variables);
-    }
-    for (varIt j=Variables.begin(); j!=Variables.end(); j++) {
-	add(*j);
-    }
+    assignOffsets();
 
     // Generate coefficient matrix and right hand side
     bool doAssemble = true;
-    if (doAssemble == true) {
-	GenerateFunctor f(cfs);
-	for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
-	    (*i)->coefficients(f);
-	    messenger->constraintDebug((*i)->getName(),cfs);
-	    assemble(cfs,coefs);
-	    cfs.erase(cfs.begin(),cfs.end());
-	}
+    if (generation == COLUMNS) {
+	generateColumns();
+    } else if (generation == STREAMING) {
+	generateStreaming();
     } else {
-	GenerateFunctor f(coefs);
-	for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
-	    (*i)->coefficients(f);
+	if (doAssemble == true && generationThreads > 1) {
+	    generateParallel(coefs);
+	} else if (doAssemble == true) {
+	    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+		generateBlock(*i,cfs,coefs);
+	    }
+	} else {
+	    GenerateFunctor f(coefs);
+	    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+		(*i)->coefficients(f);
+	    }
+	}
+	nz = static_cast<int>(coefs.size());
+
+	Elm = new double[nz]; 
+	Rnr = new int[nz];    
+	Cst = new int[n+2];   
+	Clg = new int[n+1];   
+
+	// Treat right hand side as n'th column
+	for (int j=0; j<=n; j++) {
+	    Clg[j] = 0;
+	}
+	for (int i=0; i<nz; i++) {
+	    int col = coefs.col(i);
+	    if (col == -1)  {
+		col = n;
+	    }
+	    Clg[col]++;
+	}
+	Cst[0]=0;
+	for (int j=0; j<=n; j++) {
+	    Cst[j+1]=Cst[j]+Clg[j]; 
+	}
+	for (int i=0; i<=n; i++) {
+	    Clg[i]=0;
+	}
+	for (int i=0; i<nz; i++) {
+	    int col = coefs.col(i);
+	    if (col==-1) {
+		col = n;
+	    }
+	    int row = coefs.row(i);
+	    double elm = coefs.val(i);
+	    Elm[Cst[col]+Clg[col]] = elm;
+	    Rnr[Cst[col]+Clg[col]] = row;
+	    Clg[col]++;
 	}
     }
-    nz = static_cast<int>(coefs.size());
 
     messenger->statistics(static_cast<int>(Constraints.size()),m,static_cast<int>(Variables.size()),n,nz);
 
-    Elm = new double[nz]; 
-    Rnr = new int[nz];    
-    Cst = new int[n+2];   
-    Clg = new int[n+1];   
     l =   new double[n];  
     u =   new double[n];  
     bl  = new double[m];  
@@ -277,41 +1095,6 @@ void MP_model::attach(OsiSolverInterface *_solver) {
 
     const double inf = Solver->getInfinity();
 
-    for (int j=0; j<n; j++) {
-	Clg[j] = 0;
-    }
-    Clg[n] = 0;
-    
-    // Treat right hand side as n'th column
-    for (int j=0; j<=n; j++) {
-	Clg[j] = 0;
-    }
-    for (int i=0; i<nz; i++) {
-	int col = coefs[i].col;
-	if (col == -1)  {
-	    col = n;
-	}
-	Clg[col]++;
-    }
-    Cst[0]=0;
-    for (int j=0; j<=n; j++) {
-	Cst[j+1]=Cst[j]+Clg[j]; 
-    }
-    for (int i=0; i<=n; i++) {
-	Clg[i]=0;
-    }
-    for (int i=0; i<nz; i++) {
-	int col = coefs[i].col;
-	if (col==-1) {
-	    col = n;
-	}
-	int row = coefs[i].row;
-	double elm = coefs[i].val;
-	Elm[Cst[col]+Clg[col]] = elm;
-	Rnr[Cst[col]+Clg[col]] = row;
-	Clg[col]++;
-    }
-
     // Row bounds
     for (int i=0; i<m; i++) {
 	bl[i] = 0;
@@ -343,17 +1126,31 @@ void MP_model::attach(OsiSolverInterface *_solver) {
     }
 
     // Generate objective function coefficients
-    vector<Constant> v;
+    MultiplicatorStack v;
+    DataReadRecorder recorder(incrementalAttach == true ?
+			      &objectiveReads : 0);
     if (doAssemble == true) {
 	ObjectiveGenerateFunctor f(cfs);
-	coefs.erase(coefs.begin(),coefs.end());
+	coefs.clear();
+	cfs.clear();
+	BlockProfiler profiler(messenger->profiling(),f,&cfs,&coefs);
 	Objective->generate(MP_domain::getEmpty(), v, f, 1.0);
 
-	messenger->objectiveDebug(cfs);
+	if (messenger->debugCoefficients() == true) {
+	    vector<Coef> raw;
+	    cfs.copy(raw);
+	    messenger->objectiveDebug(raw);
+	}
 	assemble(cfs,coefs);
+	if (messenger->profiling() == true) {
+	    GenerationProfile profile;
+	    profile.objective = true;
+	    profiler.stop(profile);
+	    messenger->generationProfile(profile);
+	}
     } else {
 	ObjectiveGenerateFunctor f(coefs);
-	coefs.erase(coefs.begin(),coefs.end());
+	coefs.clear();
 	Objective->generate(MP_domain::getEmpty(), v, f, 1.0);
     }	
 
@@ -362,8 +1159,11 @@ void MP_model::attach(OsiSolverInterface *_solver) {
 	c[j] = 0.0;
     }
     for (size_t i=0; i<coefs.size(); i++) {
-	int col = coefs[i].col;
-	double elm = coefs[i].val;
+	int col = coefs.col(i);
+	double elm = coefs.val(i);
+	if (col < 0) {
+	    continue;
+	}
 	c[col] = elm;
     } 
 
@@ -380,8 +1180,17 @@ void MP_model::attach(OsiSolverInterface *_solver) {
 	}
     }
 
-    CoinPackedMatrix A(true,m,n,Cst[n],Elm,Rnr,Cst,Clg);
-    Solver->loadProblem(A, l, u, c, bl, bu);
+    if (generation != TRIPLETS) {
+	// Hand the arrays over to the solver, rather than copying them.
+	CoinPackedMatrix* A = new CoinPackedMatrix;
+	A->assignMatrix(true,m,n,Cst[n],Elm,Rnr,Cst,Clg);
+	Solver->assignProblem(A, l, u, c, bl, bu);
+	Elm = 0; Rnr = 0; Cst = 0; Clg = 0;
+	l = 0; u = 0; c = 0; bl = 0; bu = 0;
+    } else {
+	CoinPackedMatrix A(true,m,n,Cst[n],Elm,Rnr,Cst,Clg);
+	Solver->loadProblem(A, l, u, c, bl, bu);
+    }
 
     // Instead of the 2 lines above we should be able to use
     // the line below, but due to a bug in OsiGlpk it does not work
@@ -406,12 +1215,397 @@ void MP_model::attach(OsiSolverInterface *_solver) {
             }
         }
     }
+    if (incrementalAttach == true) {
+	recordLoaded();
+    }
+    if (keepBasis == true) {
+	warmStart = restoreBasis();
+    }
     mSolverState = MP_model::ATTACHED;
-    messenger->generationTime(time-CoinCpuTime());
+    messenger->generationTime(CoinCpuTime()-time);
 
 }
+
+void MP_model::recordLoaded() {
+    loadedSolver = Solver;
+    loadedObjective = Objective;
+    loadedRows.resize(Constraints.size());
+    int k = 0;
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++, k++) {
+	LoadedRows& r = loadedRows[k];
+	r.constraint = *i;
+	r.offset = (*i)->offset;
+	r.size = (*i)->size();
+	r.version = (*i)->version;
+	r.reads = (*i)->reads;
+    }
+    loadedColumns.resize(Variables.size());
+    k = 0;
+    for (varIt j=Variables.begin(); j!=Variables.end(); j++, k++) {
+	LoadedColumns& c = loadedColumns[k];
+	c.variable = *j;
+	c.offset = (*j)->offset;
+	c.size = (*j)->size();
+	c.type = (*j)->type;
+	c.lowerVersion = (*j)->lowerLimit.version;
+	c.upperVersion = (*j)->upperLimit.version;
+	c.added = (*j)->added;
+    }
+}
+
+bool MP_model::reattach() {
+    double time = CoinCpuTime();
+
+    // The model must consist of the blocks loaded, with the same sizes.
+    // They keep the rows and columns they were loaded into.
+    assignOffsets();
+    if (Constraints.size() != loadedRows.size() ||
+	Variables.size() != loadedColumns.size()) {
+	return false;
+    }
+    for (size_t k=0; k<loadedRows.size(); k++) {
+	MP_constraint* c = loadedRows[k].constraint;
+	if (Constraints.count(c) == 0 || loadedRows[k].size != c->size()) {
+	    return false;
+	}
+    }
+    for (size_t k=0; k<loadedColumns.size(); k++) {
+	MP_variable* v = loadedColumns[k].variable;
+	if (Variables.count(v) == 0 || loadedColumns[k].size != v->size()) {
+	    return false;
+	}
+    }
+    for (size_t k=0; k<loadedRows.size(); k++) {
+	loadedRows[k].constraint->offset = loadedRows[k].offset;
+    }
+    for (size_t k=0; k<loadedColumns.size(); k++) {
+	loadedColumns[k].variable->offset = loadedColumns[k].offset;
+	loadedColumns[k].variable->added = loadedColumns[k].added;
+    }
+    m = Solver->getNumRows();
+    n = Solver->getNumCols();
+
+    const double inf = Solver->getInfinity();
+    // The loaded rows are copied, as modifying the solver may invalidate
+    // what it returns.
+    CoinPackedMatrix A;
+    vector<double> rowLower;
+    vector<double> rowUpper;
+    // Marks the columns of the new row being compared, with their values.
+    vector<int> stamp;
+    vector<double> slot;
+    for (size_t b=0; b<loadedRows.size(); b++) {
+	LoadedRows& block = loadedRows[b];
+	MP_constraint* c = block.constraint;
+	if (c->version == block.version && block.reads.changed() == false) {
+	    continue;
+	}
+	if (stamp.empty() == true) {
+	    A = *Solver->getMatrixByRow();
+	    rowLower.assign(Solver->getRowLower(),Solver->getRowLower()+m);
+	    rowUpper.assign(Solver->getRowUpper(),Solver->getRowUpper()+m);
+	    stamp.assign(n+1,-1);
+	    slot.assign(n+1,0.0);
+	}
+	CoefBuffer cfs;
+	CoefBuffer coefs;
+	generateBlock(c,cfs,coefs);
+
+	// The new rows, and the right hand side, in row order.
+	const int begin = block.offset;
+	const int size = block.size;
+	vector<int> start(size+1,0);
+	vector<double> rhs(size,0.0);
+	for (size_t e=0; e<coefs.size(); e++) {
+	    if (coefs.col(e) == -1) {
+		rhs[coefs.row(e)-begin] = -coefs.val(e);
+	    } else {
+		start[coefs.row(e)-begin+1]++;
+	    }
+	}
+	for (int r=0; r<size; r++) {
+	    start[r+1] += start[r];
+	}
+	vector<int> cols(start[size]);
+	vector<double> vals(start[size]);
+	vector<int> fill(start.begin(),start.end()-1);
+	for (size_t e=0; e<coefs.size(); e++) {
+	    if (coefs.col(e) != -1) {
+		const int r = coefs.row(e)-begin;
+		cols[fill[r]] = coefs.col(e);
+		vals[fill[r]] = coefs.val(e);
+		fill[r]++;
+	    }
+	}
+
+	const CoinBigIndex* rowStart = A.getVectorStarts();
+	const int* rowLength = A.getVectorLengths();
+	const int* index = A.getIndices();
+	const double* element = A.getElements();
+	for (int r=0; r<size; r++) {
+	    const int row = begin+r;
+	    for (int e=start[r]; e<start[r+1]; e++) {
+		stamp[cols[e]] = row;
+		slot[cols[e]] = vals[e];
+	    }
+	    for (CoinBigIndex e=rowStart[row]; e<rowStart[row]+rowLength[row];
+		 e++) {
+		const int col = index[e];
+		if (stamp[col] == row) {
+		    if (slot[col] != element[e]) {
+			Solver->modifyCoefficient(row,col,slot[col]);
+		    }
+		    stamp[col] = -1;
+		} else if (element[e] != 0.0) {
+		    Solver->modifyCoefficient(row,col,0.0);
+		}
+	    }
+	    for (int e=start[r]; e<start[r+1]; e++) {
+		if (stamp[cols[e]] == row) {
+		    if (vals[e] != 0.0) {
+			Solver->modifyCoefficient(row,cols[e],vals[e]);
+		    }
+		    stamp[cols[e]] = -1;
+		}
+	    }
+
+	    // Row bounds, as in attach().
+	    double lower = rhs[r];
+	    double upper = rhs[r];
+	    if (c->sense == LE) {
+		lower = -inf;
+	    } else if (c->sense == GE) {
+		upper = inf;
+	    }
+	    if (lower != rowLower[row] || upper != rowUpper[row]) {
+		Solver->setRowBounds(row,lower,upper);
+	    }
+	}
+	block.version = c->version;
+	block.reads = c->reads;
+    }
+
+    if (Objective.operator->() != loadedObjective.operator->() ||
+	objectiveReads.changed() == true) {
+	CoefBuffer cfs;
+	CoefBuffer coefs;
+	MultiplicatorStack v;
+	ObjectiveGenerateFunctor f(cfs);
+	BlockProfiler profiler(messenger->profiling(),f,&cfs,&coefs);
+	{
+	    DataReadRecorder recorder(&objectiveReads);
+	    Objective->generate(MP_domain::getEmpty(), v, f, 1.0);
+	}
+	if (messenger->debugCoefficients() == true) {
+	    vector<Coef> raw;
+	    cfs.copy(raw);
+	    messenger->objectiveDebug(raw);
+	}
+	assemble(cfs,coefs);
+	if (messenger->profiling() == true) {
+	    GenerationProfile profile;
+	    profile.objective = true;
+	    profiler.stop(profile);
+	    messenger->generationProfile(profile);
+	}
+	vector<double> obj(n,0.0);
+	for (size_t e=0; e<coefs.size(); e++) {
+	    if (coefs.col(e) < 0) {
+		continue;
+	    }
+	    obj[coefs.col(e)] = coefs.val(e);
+	}
+	const vector<double> objective(Solver->getObjCoefficients(),
+				       Solver->getObjCoefficients()+n);
+	for (int j=0; j<n; j++) {
+	    if (obj[j] != objective[j]) {
+		Solver->setObjCoeff(j,obj[j]);
+	    }
+	}
+	loadedObjective = Objective;
+    }
+
+    for (size_t b=0; b<loadedColumns.size(); b++) {
+	LoadedColumns& loaded = loadedColumns[b];
+	MP_variable* v = loaded.variable;
+	if (v->lowerLimit.version != loaded.lowerVersion ||
+	    v->upperLimit.version != loaded.upperVersion) {
+	    const vector<double> colLower(Solver->getColLower(),
+					  Solver->getColLower()+n);
+	    const vector<double> colUpper(Solver->getColUpper(),
+					  Solver->getColUpper()+n);
+	    for (int j=0; j<loaded.size; j++) {
+		const int col = v->column(j);
+		if (v->lowerLimit.v[j] != colLower[col] ||
+		    v->upperLimit.v[j] != colUpper[col]) {
+		    Solver->setColBounds(col,v->lowerLimit.v[j],
+					 v->upperLimit.v[j]);
+		}
+	    }
+	    loaded.lowerVersion = v->lowerLimit.version;
+	    loaded.upperVersion = v->upperLimit.version;
+	}
+	if (v->type != loaded.type) {
+	    for (int j=0; j<loaded.size; j++) {
+		if (v->type == discrete) {
+		    Solver->setInteger(v->column(j));
+		} else {
+		    Solver->setContinuous(v->column(j));
+		}
+	    }
+	    loaded.type = v->type;
+	}
+    }
+
+    mSolverState = MP_model::ATTACHED;
+    warmStart = true;
+    messenger->generationTime(CoinCpuTime()-time);
+    return true;
+}
+
+namespace {
+    /// the row of an element of a constraint block.
+    struct RowOf {
+	RowOf(const MP_constraint* c) : offset(c->offset) {}
+	int operator()(int k) const {
+	    return offset+k;
+	}
+	int offset;
+    };
+    /// the column of an element of a variable.
+    struct ColumnOf {
+	ColumnOf(const MP_variable* v) : variable(v) {}
+	int operator()(int k) const {
+	    return variable->column(k);
+	}
+	const MP_variable* variable;
+    };
+
+    /// saves the statuses of the n elements of a block from the basis.
+    template <class Index, class Status>
+    void saveStatus(Index index, int n, Status status, vector<char>& s) {
+	s.resize(n);
+	for (int k=0; k<n; k++) {
+	    s[k] = static_cast<char>(status(index(k)));
+	}
+    }
+
+    /** restores saved statuses, saved with the index set sizes from, into
+	a block whose index sets have the sizes to, by the indices of the
+	elements.
+    */
+    template <class Index, class Restore>
+    void restoreStatus(const int from[5], const vector<char>& s,
+		       const int to[5], Index index, Restore restore) {
+	for (size_t k=0; k<s.size(); k++) {
+	    // The indices of element k, as RowMajor::f() orders them.
+	    int i[5];
+	    int rest = static_cast<int>(k);
+	    for (int d=4; d>=0; d--) {
+		i[d] = rest % from[d];
+		rest /= from[d];
+	    }
+	    int l = 0;
+	    bool inside = true;
+	    for (int d=0; d<5; d++) {
+		if (i[d] >= to[d]) {
+		    inside = false;
+		}
+		l = l*to[d] + i[d];
+	    }
+	    if (inside == true) {
+		restore(index(l),static_cast<CoinWarmStartBasis::Status>(s[k]));
+	    }
+	}
+    }
+
+    struct RowStatus {
+	RowStatus(CoinWarmStartBasis* b) : basis(b) {}
+	CoinWarmStartBasis::Status operator()(int i) const {
+	    return basis->getArtifStatus(i);
+	}
+	void operator()(int i, CoinWarmStartBasis::Status s) const {
+	    basis->setArtifStatus(i,s);
+	}
+	CoinWarmStartBasis* basis;
+    };
+    struct ColumnStatus {
+	ColumnStatus(CoinWarmStartBasis* b) : basis(b) {}
+	CoinWarmStartBasis::Status operator()(int j) const {
+	    return basis->getStructStatus(j);
+	}
+	void operator()(int j, CoinWarmStartBasis::Status s) const {
+	    basis->setStructStatus(j,s);
+	}
+	CoinWarmStartBasis* basis;
+    };
+}
+
+void MP_model::saveBasis() {
+    CoinWarmStart* ws = Solver->getWarmStart();
+    CoinWarmStartBasis* basis = dynamic_cast<CoinWarmStartBasis*>(ws);
+    if (basis == 0 || basis->getNumArtificial() != m ||
+	basis->getNumStructural() != n) {
+	delete ws;
+	return;
+    }
+    rowStatus.clear();
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+	BlockStatus& s = rowStatus[*i];
+	const int size[5] = {(*i)->size1,(*i)->size2,(*i)->size3,
+			     (*i)->size4,(*i)->size5};
+	std::copy(size,size+5,s.size);
+	saveStatus(RowOf(*i),(*i)->size(),RowStatus(basis),s.status);
+    }
+    columnStatus.clear();
+    for (varIt j=Variables.begin(); j!=Variables.end(); j++) {
+	BlockStatus& s = columnStatus[*j];
+	const int size[5] = {(*j)->active,(*j)->size2,(*j)->size3,
+			     (*j)->size4,(*j)->size5};
+	std::copy(size,size+5,s.size);
+	saveStatus(ColumnOf(*j),(*j)->size(),ColumnStatus(basis),s.status);
+    }
+    delete ws;
+}
+
+bool MP_model::restoreBasis() {
+    if (rowStatus.empty() == true && columnStatus.empty() == true) {
+	return false;
+    }
+    CoinWarmStartBasis basis;
+    basis.setSize(n,m);
+    for (int j=0; j<n; j++) {
+	basis.setStructStatus(j,CoinWarmStartBasis::atLowerBound);
+    }
+    for (int i=0; i<m; i++) {
+	basis.setArtifStatus(i,CoinWarmStartBasis::basic);
+    }
+    for (conIt i=Constraints.begin(); i!=Constraints.end(); i++) {
+	map<const MP_constraint*,BlockStatus>::const_iterator s =
+	    rowStatus.find(*i);
+	if (s != rowStatus.end()) {
+	    const int size[5] = {(*i)->size1,(*i)->size2,(*i)->size3,
+				 (*i)->size4,(*i)->size5};
+	    restoreStatus(s->second.size,s->second.status,size,RowOf(*i),
+			  RowStatus(&basis));
+	}
+    }
+    for (varIt j=Variables.begin(); j!=Variables.end(); j++) {
+	map<const MP_variable*,BlockStatus>::const_iterator s =
+	    columnStatus.find(*j);
+	if (s != columnStatus.end()) {
+	    const int size[5] = {(*j)->active,(*j)->size2,(*j)->size3,
+				 (*j)->size4,(*j)->size5};
+	    restoreStatus(s->second.size,s->second.status,size,ColumnOf(*j),
+			  ColumnStatus(&basis));
+	}
+    }
+    return Solver->setWarmStart(&basis);
+}
+
 void MP_model::detach() {
     assert(Solver);
+    loadedSolver = 0;
     mSolverState=MP_model::DETACHED;
     /// @todo strip all data out of the solver.
     delete Solver;
@@ -444,11 +1638,19 @@ MP_model::MP_status MP_model::solve(const MP_model::MP_direction &dir) {
 	}
     } else {
 	try {
-	    Solver->initialSolve();
+	    if (warmStart == true) {
+		// Starts from the basis in the solver.
+		Solver->resolve();
+	    } else {
+		Solver->initialSolve();
+	    }
 	}  catch (CoinError e) {
 	    cout<<e.message()<<endl;
 	}
     }
+    if (keepBasis == true) {
+	saveBasis();
+    }
      
     if (Solver->isProvenOptimal() == true) {
 	cout<<"FlopCpp: Optimal obj. value = "<<Solver->getObjValue()<<endl;
@@ -12,6 +12,7 @@
 #include <ostream>
 #include <vector>
 #include <set>
+#include <map>
 #include <string>
 
 #include "MP_expression.hpp"
@@ -24,6 +25,37 @@ namespace flopc {
     class MP_variable;
     class MP_index;
     class MP_set;
+    class CoefSpill;
+
+    /** @brief What generating one constraint block, or the objective, cost.
+        @ingroup PublicInterface
+        Passed to Messenger::generationProfile() for every block generated,
+        if Messenger::profiling() returns true.
+    */
+    struct GenerationProfile {
+        GenerationProfile() : objective(false), wallTime(0.0), cpuTime(0.0),
+            tuples(0), coefficients(0), nonzeros(0), bufferGrowth(0) {}
+        /// name of the constraint block.
+        std::string name;
+        /// true for the objective.
+        bool objective;
+        /// seconds spent generating and merging the coefficients.
+        double wallTime;
+        /// CPU seconds of the generating thread.
+        double cpuTime;
+        /// number of domain elements generated for, summed over the terms.
+        size_t tuples;
+        /// number of coefficients generated, before duplicates are merged.
+        size_t coefficients;
+        /// number of coefficients after merging, including the rhs.
+        size_t nonzeros;
+        /** bytes the coefficient buffers of TRIPLETS generation grew by.
+            Not the memory used by the COLUMNS and STREAMING generation,
+            whose column arrays and spill buffers are shared by all the
+            blocks, so it is 0 for them.
+        */
+        size_t bufferGrowth;
+    };
 
     /** @brief Inteface for hooking up to internal flopc++ message handling.
         @ingroup PublicInterface
@@ -41,6 +73,16 @@ namespace flopc {
         virtual void objectiveDebug(const std::vector<Coef>& cfs) {}
         virtual void statistics(int bm, int m, int bn, int n, int nz) {}
         virtual void generationTime(double t) {}
+        /// called for every constraint block generated, and the objective.
+        virtual void generationProfile(const GenerationProfile& p) {}
+        /** returns true if generationProfile() is to be called, at the
+            cost of timing every block.
+        */
+        virtual bool profiling() const { return false; }
+        /** returns false if constraintDebug() and objectiveDebug() ignore
+            the coefficients, which then need not be copied for them.
+        */
+        virtual bool debugCoefficients() const { return true; }
     protected:
         virtual ~Messenger() {}
     };
@@ -50,9 +92,11 @@ namespace flopc {
     */
     class NormalMessenger : public Messenger {
         friend class MP_model;
+        friend class ProfilingMessenger;
     private:
         virtual void statistics(int bm, int m, int bn, int n, int nz);
         virtual void generationTime(double t);
+        virtual bool debugCoefficients() const { return false; }
     };
 
     /** Internal use: used when Verbose output is selected. Uses cout.
@@ -63,6 +107,30 @@ namespace flopc {
     private:
         virtual void constraintDebug(std::string name, const std::vector<Coef>& cfs);
         virtual void objectiveDebug(const std::vector<Coef>& cfs);
+        virtual bool debugCoefficients() const { return true; }
+    };
+
+    /** @brief Normal output, followed after the generation time by what
+        every constraint block and the objective cost to generate, most
+        expensive first.  Uses cout.
+        @ingroup PublicInterface
+        Pass it to the MP_model constructor to find the blocks worth
+        reformulating.
+    */
+    class ProfilingMessenger : public NormalMessenger {
+        friend class MP_model;
+    public:
+        ProfilingMessenger() : complete(false) {}
+        /// the profiles of the last generation, in generation order.
+        const std::vector<GenerationProfile>& getProfiles() const {
+            return profiles;
+        }
+    private:
+        virtual void generationTime(double t);
+        virtual void generationProfile(const GenerationProfile& p);
+        virtual bool profiling() const { return true; }
+        std::vector<GenerationProfile> profiles;
+        bool complete;
     };
 
     /** @brief This is the anchor point for all constructs in a FlopC++ model.
@@ -113,6 +181,25 @@ namespace flopc {
             DETACHED
         } MP_status;
 
+        /// Ways in which attach() can build the constraint matrix.
+        typedef enum {
+            /// every constraint block is generated into a list of
+            /// coefficients, which is sorted and merged.
+            TRIPLETS,
+            /// the constraints are generated twice: once to count the
+            /// column lengths, and once to scatter the coefficients
+            /// directly into column ordered arrays, which are handed over
+            /// to the solver.  Uses much less memory than TRIPLETS at the
+            /// price of generating twice.
+            COLUMNS,
+            /// the coefficients are generated once into sorted runs on
+            /// temporary files, which are merged into the column ordered
+            /// arrays.  Generation buffers stay within the generation
+            /// memory budget.
+            /// @see setGenerationMemory()
+            STREAMING
+        } MP_generation;
+
         /// Constructs an MP_model from an OsiSolverInterface *.
         MP_model(OsiSolverInterface* s, Messenger* m = new NormalMessenger);
 
@@ -146,6 +233,108 @@ namespace flopc {
             Solver = s;
         }
 
+        /** @brief sets the number of threads used to generate the
+            constraint blocks in attach().
+            With more than one thread every constraint block is generated
+            into a buffer of its own on a pool of worker threads, and the
+            buffers are merged in the same block order as the serial
+            generation, so the resulting matrix is identical.
+            The default is 1 (serial generation).
+        */
+        void setGenerationThreads(int t) {
+            generationThreads = (t < 1) ? 1 : t;
+        }
+        /// returns the number of threads used to generate constraint blocks.
+        int getGenerationThreads() const {
+            return generationThreads;
+        }
+
+        /** @brief selects how attach() builds the constraint matrix.
+            The default is TRIPLETS.  COLUMNS and STREAMING generation
+            are always serial and do not report the coefficients of every
+            block to a VerboseMessenger.
+            @see MP_generation
+        */
+        void setGeneration(MP_generation g) {
+            generation = g;
+        }
+        /// returns how attach() builds the constraint matrix.
+        MP_generation getGeneration() const {
+            return generation;
+        }
+
+        /** @brief sets the number of bytes STREAMING generation may use
+            for buffering coefficients.  The default is 256 MB.
+        */
+        void setGenerationMemory(size_t bytes) {
+            generationMemory = bytes;
+        }
+        /// returns the memory budget of STREAMING generation.
+        size_t getGenerationMemory() const {
+            return generationMemory;
+        }
+
+        /** @brief lowers every constraint block to a flat program, which
+            is run instead of walking its expression trees.
+            Works with all generation modes.  Blocks with a domain which is
+            not a product of sets (e.g. over a subset) are still generated
+            by walking the trees.  With check set, every compiled block is
+            also generated by walking the trees, and if the results differ
+            a warning is printed and the coefficients of the tree walk are
+            used.  Off by default.
+            @see CompiledConstraint
+        */
+        void setCompiledGeneration(bool compiled, bool check = false) {
+            compiledGeneration = compiled;
+            compiledCheck = check;
+        }
+        /// returns true if constraint blocks are compiled before generation.
+        bool getCompiledGeneration() const {
+            return compiledGeneration;
+        }
+
+        /** @brief makes attach() update a model already loaded into the
+            same solver in place, rather than loading it again.
+            attach() then regenerates only the constraint blocks whose
+            definition, or any MP_data or MP_subset read while generating
+            them, has changed since the model was loaded, and the objective
+            if it has changed.  Their rows are updated with modifyCoefficient()
+            and setRowBounds(), the objective with setObjCoeff(), and the
+            changed variable bounds with setColBounds(), which keeps the
+            basis of the solver; solve() then calls resolve() for an LP.
+            If constraint blocks or variables have been added, or their
+            sizes have changed, the model is loaded again.
+            @note Values changed through the array an MP_data was constructed
+            over must be announced with MP_data::markChanged().
+            Off by default.
+        */
+        void setIncrementalAttach(bool incremental) {
+            incrementalAttach = incremental;
+        }
+        /// returns true if attach() updates a loaded model in place.
+        bool getIncrementalAttach() const {
+            return incrementalAttach;
+        }
+
+        /** @brief keeps the basis of the solver across loads of the model.
+            After every solve() the basis status of every row and column
+            is saved by its constraint block or variable and its indices.
+            When attach() loads the model again, the saved statuses are
+            moved to wherever their rows and columns are now, also if
+            blocks have been added or removed or have changed size, and
+            set as warm start of the solver.  Rows not in the saved basis
+            are basic, columns at their lower bound.  solve() then calls
+            resolve() for an LP.
+            Off by default.
+        */
+        void setKeepBasis(bool keep) {
+            keepBasis = keep;
+        }
+        /// returns true if the basis is kept across loads of the model.
+        bool getKeepBasis() const {
+            return keepBasis;
+        }
+
         /// allows access to the OsiSolverInterface *
         OsiSolverInterface* operator->() {
             return Solver;
@@ -189,6 +378,15 @@ namespace flopc {
             or as late as the call to attach()
 	*/
         void attach(OsiSolverInterface *solver=NULL);
+	/** @brief writes the model to a free format MPS file without
+            attaching it to a solver.
+            The coefficients are generated as with STREAMING generation and
+            written while the runs are merged, so only the objective, the
+            bounds and the right hand side are held in memory.  Rows are
+            named R0, R1, ..., columns C0, C1, ... in the order attach()
+            uses, and the objective row is OBJ.
+	*/
+        void generateMps(const std::string& fileName);
 	/** @brief detaches an OsiSolverInterface object from the model.  
             In essence, this will clean up any intermediate storage. A model 
             may then be attached to another solverInterface.
@@ -221,6 +419,37 @@ namespace flopc {
         void add(MP_variable* v);
         /// Adds a constraint to the MP_model
         void addRow(const Constraint& c); 
+        /** @brief Adds a constraint block to the attached model, after the
+            rows already loaded.
+            The block is generated and assembled as by attach() and its
+            rows are added with a single call of the solver's addRows().
+            The block keeps these rows, so price() can be used on it after
+            the next solve().  If no solver is attached the block is only
+            added to the model.  Nothing is added if the block uses
+            variables which are not in the attached model.
+        */
+        void addRows(MP_constraint& c);
+        /** @brief Grows a variable by the elements of the next count values
+            of its first index, e.g. while generating columns.
+            In the attached model the new elements become columns after
+            those already loaded.  Their coefficients are generated from
+            the loaded constraint blocks using the variable and from the
+            objective, and added with a single call of the solver's
+            addCols(), with the bounds and type of the variable.
+            Afterwards the variable, including level() and display(),
+            covers the new columns.  If no solver is attached the variable
+            only grows.
+            @see MP_variable::setActive()
+        */
+        void addColumns(MP_variable& v, int count);
+
+        /** @brief Appends the coefficients of v to av in (col,row) order,
+            with the duplicates of each (col,row) summed in the order they
+            are in v, and the highest of their stages.
+            Sorts in linear time unless the coefficients are spread over
+            many more columns and rows than there are coefficients.
+        */
+        static void assemble(CoefBuffer& v, CoefBuffer& av);
 
         /** Can be used to get the default model
             @todo explain the default and current model concepts.
@@ -236,6 +465,8 @@ namespace flopc {
             return messenger;
         }
     private:
+        friend class GenerateBlock;
+        friend class CoefSpill;
         typedef std::set<MP_variable* >::iterator varIt;
         typedef std::set<MP_constraint* >::iterator conIt;
         static MP_model& default_model;
@@ -246,8 +477,26 @@ namespace flopc {
         Messenger* messenger;
    
     
-        static void assemble(std::vector<Coef>& v, std::vector<Coef>& av);
+        /** sets order to the positions in v by (col,row), and by position
+            for the same (col,row).
+        */
+        static void sortCoefficients(const CoefBuffer& v,
+                                     std::vector<int>& order);
+        void constraintDebug(const MP_constraint* c, const CoefBuffer& cfs);
+        void generateParallel(CoefBuffer& coefs);
+        void generateColumns();
+        void generateStreaming();
+        void assignOffsets();
+        void spillConstraints(CoefSpill& spill,
+                              std::vector<GenerationProfile>& profiles);
+        void rowNonzeros(std::vector<GenerationProfile>& profiles) const;
         void add(MP_constraint* c);
+        bool reattach();
+        void recordLoaded();
+        void generateBlock(MP_constraint* c, CoefBuffer& cfs,
+                           CoefBuffer& coefs);
+        void saveBasis();
+        bool restoreBasis();
         MP_expression Objective;
         std::set<MP_constraint *> Constraints;
         std::set<MP_variable *> Variables;
@@ -268,6 +517,49 @@ namespace flopc {
         double *l;
         double *u;
         MP_status mSolverState;
+        int generationThreads;
+        MP_generation generation;
+        size_t generationMemory;
+        bool compiledGeneration;
+        bool compiledCheck;
+        bool incrementalAttach;
+
+        /// a constraint block as loaded into the solver.
+        struct LoadedRows {
+            MP_constraint* constraint;
+            int offset;
+            int size;
+            int version;
+            DataDependencies reads;
+        };
+        /// a variable as loaded into the solver.
+        struct LoadedColumns {
+            MP_variable* variable;
+            int offset;
+            int size;
+            int type;
+            int lowerVersion;
+            int upperVersion;
+            std::vector<std::pair<int,int> > added;
+        };
+        /// the solver the model was loaded into, 0 if none.
+        OsiSolverInterface* loadedSolver;
+        std::vector<LoadedRows> loadedRows;
+        std::vector<LoadedColumns> loadedColumns;
+        MP_expression loadedObjective;
+        DataDependencies objectiveReads;
+
+        bool keepBasis;
+        /// the basis statuses of the elements of a block, by their index.
+        struct BlockStatus {
+            /// the sizes of the index sets of the block when saved
+            int size[5];
+            std::vector<char> status;
+        };
+        std::map<const MP_constraint*, BlockStatus> rowStatus;
+        std::map<const MP_variable*, BlockStatus> columnStatus;
+        /// true if solve() can start from the basis in the solver.
+        bool warmStart;
     };
     
     /// allows print of result from call to solve();
@@ -0,0 +1,174 @@
+// ******************** FlopCpp **********************************************
+// File: MP_parallel.cpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+//****************************************************************************
+
+#include <exception>
+#include <CoinError.hpp>
+#include <CoinTime.hpp>
+#include "MP_parallel.hpp"
+#include "MP_index.hpp"
+
+#ifndef _MSC_VER
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#define FLOPC_HAS_PTHREAD
+#endif
+
+using namespace flopc;
+using namespace std;
+
+#ifdef FLOPC_HAS_PTHREAD
+
+Mutex::Mutex() : impl(new pthread_mutex_t) {
+    pthread_mutex_init(static_cast<pthread_mutex_t*>(impl), NULL);
+}
+
+Mutex::~Mutex() {
+    pthread_mutex_destroy(static_cast<pthread_mutex_t*>(impl));
+    delete static_cast<pthread_mutex_t*>(impl);
+}
+
+void Mutex::lock() {
+    pthread_mutex_lock(static_cast<pthread_mutex_t*>(impl));
+}
+
+void Mutex::unlock() {
+    pthread_mutex_unlock(static_cast<pthread_mutex_t*>(impl));
+}
+
+namespace {
+    struct TaskQueue {
+	TaskQueue(const vector<const Functor*>& t) : 
+	    tasks(t), next(0), error(0) {}
+	~TaskQueue() {
+	    delete error;
+	}
+	/// keeps the first error, and hands out no more tasks.
+	void fail(const CoinError& e) {
+	    ScopedLock guard(lock);
+	    if (error == 0) {
+		error = new CoinError(e);
+	    }
+	    next = tasks.size();
+	}
+	const vector<const Functor*>& tasks;
+	size_t next;
+	CoinError* error;
+	Mutex lock;
+    };
+
+    void runTasks(TaskQueue* q) {
+	// Index bindings made by the tasks stay local to this worker.
+	EvaluationContext context;
+	ContextBinder binder(context);
+	for (;;) {
+	    size_t k;
+	    {
+		ScopedLock guard(q->lock);
+		k = q->next++;
+	    }
+	    if (k >= q->tasks.size()) {
+		break;
+	    }
+	    (*q->tasks[k])();
+	}
+    }
+
+    // An exception may not leave a thread, so it is passed to run().
+    void* runWorker(void* arg) {
+	TaskQueue* q = static_cast<TaskQueue*>(arg);
+	try {
+	    runTasks(q);
+	} catch (CoinError& e) {
+	    q->fail(e);
+	} catch (std::exception& e) {
+	    q->fail(CoinError(e.what(), "run", "WorkerPool"));
+	} catch (...) {
+	    q->fail(CoinError("unknown exception", "run", "WorkerPool"));
+	}
+	return NULL;
+    }
+
+    void joinAll(const vector<pthread_t>& workers) {
+	for (size_t i=0; i<workers.size(); i++) {
+	    pthread_join(workers[i], NULL);
+	}
+    }
+}
+
+void WorkerPool::run(const vector<const Functor*>& tasks) {
+    TaskQueue q(tasks);
+    size_t nWorkers = nThreads;
+    if (nWorkers > tasks.size()) {
+	nWorkers = tasks.size();
+    }
+    // The calling thread is the first worker.
+    vector<pthread_t> workers;
+    for (size_t i=1; i<nWorkers; i++) {
+	pthread_t t;
+	if (pthread_create(&t, NULL, runWorker, &q) == 0) {
+	    workers.push_back(t);
+	}
+    }
+    // The workers use q until they are joined, whatever the calling
+    // thread throws.
+    try {
+	runTasks(&q);
+    } catch (...) {
+	{
+	    ScopedLock guard(q.lock);
+	    q.next = tasks.size();
+	}
+	joinAll(workers);
+	throw;
+    }
+    joinAll(workers);
+    if (q.error != 0) {
+	throw CoinError(*q.error);
+    }
+}
+
+int WorkerPool::hardwareThreads() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? static_cast<int>(n) : 1;
+}
+
+double WorkerPool::threadCpuTime() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec t;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID,&t) == 0) {
+	return t.tv_sec + t.tv_nsec*1e-9;
+    }
+#endif
+    return CoinCpuTime();
+}
+
+#else
+
+Mutex::Mutex() : impl(0) {}
+Mutex::~Mutex() {}
+void Mutex::lock() {}
+void Mutex::unlock() {}
+
+void WorkerPool::run(const vector<const Functor*>& tasks) {
+    for (size_t k=0; k<tasks.size(); k++) {
+	(*tasks[k])();
+    }
+}
+
+int WorkerPool::hardwareThreads() {
+    return 1;
+}
+
+double WorkerPool::threadCpuTime() {
+    return CoinCpuTime();
+}
+
+#endif
+
+WorkerPool::WorkerPool(int n) : nThreads(n < 1 ? 1 : n) {}
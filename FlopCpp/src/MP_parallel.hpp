@@ -0,0 +1,91 @@
+// ******************** FlopCpp **********************************************
+// File: MP_parallel.hpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+// ****************************************************************************
+
+#ifndef _MP_parallel_hpp_
+#define _MP_parallel_hpp_
+
+#include <vector>
+
+#include "MP_utilities.hpp"
+
+namespace flopc {
+
+    /** @brief Mutual exclusion lock.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        On platforms without pthreads this is a no-op.
+    */
+    class Mutex {
+    public:
+	Mutex();
+	~Mutex();
+	void lock();
+	void unlock();
+    private:
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+	void* impl;
+    };
+
+    /** @brief Holds a Mutex for the lifetime of the object.
+        @ingroup INTERNAL_USE
+    */
+    class ScopedLock {
+    public:
+	ScopedLock(Mutex& m) : M(m) {
+	    M.lock();
+	}
+	~ScopedLock() {
+	    M.unlock();
+	}
+    private:
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator=(const ScopedLock&);
+	Mutex& M;
+    };
+
+    /** @brief Fixed size pool of worker threads.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        run() hands the tasks out to the workers in list order and returns
+        when every task has been called exactly once.  The order in which
+        the tasks <em>finish</em> is not defined, so a task must write its
+        result to storage of its own.  With one thread, or on platforms
+        without pthreads, the tasks are called in the calling thread.
+        <br> If a task throws, no more tasks are started, and run() throws
+        once every worker has finished: the exception itself if thrown in
+        the calling thread, and otherwise a CoinError, holding the message
+        of a std::exception.
+    */
+    class WorkerPool {
+    public:
+	WorkerPool(int nThreads);
+	~WorkerPool() {}
+
+	/// number of threads used by run()
+	int size() const {
+	    return nThreads;
+	}
+	void run(const std::vector<const Functor*>& tasks);
+
+	/// number of processors available, or 1 if it cannot be determined.
+	static int hardwareThreads();
+	/** CPU seconds used by the calling thread, or by the process if
+	    that cannot be determined.
+	*/
+	static double threadCpuTime();
+    private:
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+	int nThreads;
+    };
+
+} // End of namespace flopc
+#endif
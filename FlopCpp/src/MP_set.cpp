@@ -9,6 +9,7 @@
 #include "MP_set.hpp"
 #include "MP_model.hpp"
 #include <sstream>
+#include <algorithm>
 using namespace flopc;
 
 namespace flopc {
@@ -18,6 +19,254 @@ namespace flopc {
 	return Empty;
     }
     
+}
+
+namespace {
+    unsigned int hashValues(const int* key, int width) {
+	unsigned int h = 2166136261u;
+	for (int j=0; j<width; j++) {
+	    h = (h ^ static_cast<unsigned int>(key[j]))*16777619u;
+	}
+	return h;
+    }
+
+    unsigned int hashKey(CoinUInt64 key) {
+	unsigned int h = static_cast<unsigned int>(key)*2654435761u ^ 
+	    static_cast<unsigned int>(key >> 32)*2246822519u;
+	return h ^ (h >> 15);
+    }
+
+    class KeyLess {
+    public:
+	KeyLess(const std::vector<CoinUInt64>& k) : keys(k) {}
+	bool operator()(int a, int b) const {
+	    return keys[a] < keys[b];
+	}
+    private:
+	const std::vector<CoinUInt64>& keys;
+    };
+
+    class TupleLess {
+    public:
+	TupleLess(const std::vector<int>& t, int w) : tuples(t), width(w) {}
+	bool operator()(int a, int b) const {
+	    return std::lexicographical_compare(
+		&tuples[a*width],&tuples[a*width]+width,
+		&tuples[b*width],&tuples[b*width]+width);
+	}
+    private:
+	const std::vector<int>& tuples;
+	int width;
+    };
+}
+
+namespace flopc {
+
+    SubsetElements::SubsetElements(int w) : 
+	width(w), n(0), packed(true), base(w,0), table(16,-1) {}
+
+    bool SubsetElements::pack(const int* t, CoinUInt64& key) const {
+	key = 0;
+	for (int j=0; j<width; j++) {
+	    if (t[j] < 0 || t[j] >= base[j]) {
+		return false;
+	    }
+	    key = key*base[j] + t[j];
+	}
+	return true;
+    }
+
+    void SubsetElements::values(int e, int* t) const {
+	if (packed == true) {
+	    CoinUInt64 key = keys[e];
+	    for (int j=width-1; j>=0; j--) {
+		t[j] = static_cast<int>(key % base[j]);
+		key /= base[j];
+	    }
+	} else {
+	    std::copy(&tuples[e*width],&tuples[e*width]+width,t);
+	}
+    }
+
+    unsigned int SubsetElements::hash(const int* t, CoinUInt64 key) const {
+	return packed == true ? hashKey(key) : hashValues(t,width);
+    }
+
+    unsigned int SubsetElements::hash(int e) const {
+	return packed == true ? hashKey(keys[e]) : 
+	    hashValues(&tuples[e*width],width);
+    }
+
+    bool SubsetElements::same(int e, const int* t, CoinUInt64 key) const {
+	if (packed == true) {
+	    return keys[e] == key;
+	}
+	return std::equal(t,t+width,&tuples[e*width]);
+    }
+
+    int SubsetElements::find(const int* t) const {
+	CoinUInt64 key = 0;
+	if (n == 0 || (packed == true && pack(t,key) == false)) {
+	    return outOfBound;
+	}
+	const size_t mask = table.size()-1;
+	for (size_t k=hash(t,key) & mask; table[k] >= 0; k = (k+1) & mask) {
+	    if (same(table[k],t,key) == true) {
+		return table[k];
+	    }
+	}
+	return outOfBound;
+    }
+
+    void SubsetElements::place(int e) {
+	const size_t mask = table.size()-1;
+	size_t k = hash(e) & mask;
+	while (table[k] >= 0) {
+	    k = (k+1) & mask;
+	}
+	table[k] = e;
+    }
+
+    void SubsetElements::insert(const int* t, const int* sizes) {
+	if (find(t) != outOfBound) {
+	    return;
+	}
+	CoinUInt64 key = 0;
+	if (packed == true && pack(t,key) == false) {
+	    std::vector<int> bases(base);
+	    for (int j=0; j<width; j++) {
+		bases[j] = std::max(bases[j],std::max(sizes[j],t[j]+1));
+	    }
+	    repack(bases);
+	}
+	if (packed == true) {
+	    pack(t,key);
+	    keys.push_back(key);
+	} else {
+	    tuples.insert(tuples.end(),t,t+width);
+	}
+	n++;
+	if (2*static_cast<size_t>(n) > table.size()) {
+	    table.assign(2*table.size(),-1);
+	    for (int e=0; e<n; e++) {
+		place(e);
+	    }
+	} else {
+	    place(n-1);
+	}
+    }
+
+    void SubsetElements::repack(const std::vector<int>& bases) {
+	const CoinUInt64 largest = ~static_cast<CoinUInt64>(0);
+	CoinUInt64 product = 1;
+	bool fits = true;
+	for (int j=0; j<width; j++) {
+	    if (product > largest/bases[j]) {
+		fits = false;
+	    }
+	    product *= bases[j];
+	}
+	std::vector<int> all(n*width);
+	for (int e=0; e<n; e++) {
+	    values(e,&all[e*width]);
+	}
+	base = bases;
+	keys.clear();
+	if (fits == true) {
+	    for (int e=0; e<n; e++) {
+		CoinUInt64 key;
+		pack(&all[e*width],key);
+		keys.push_back(key);
+	    }
+	} else {
+	    packed = false;
+	    tuples.swap(all);
+	}
+	table.assign(table.size(),-1);
+	for (int e=0; e<n; e++) {
+	    place(e);
+	}
+    }
+
+    void SubsetElements::sort(std::vector<int>& order) const {
+	order.resize(n);
+	for (int e=0; e<n; e++) {
+	    order[e] = e;
+	}
+	// The keys have the order of the values, the first the most
+	// significant.
+	if (packed == true) {
+	    std::sort(order.begin(),order.end(),KeyLess(keys));
+	} else {
+	    std::sort(order.begin(),order.end(),TupleLess(tuples,width));
+	}
+    }
+
+    SubsetIndex::SubsetIndex(const std::vector<int>& values, int w) : 
+	width(w) {
+	const int n = width == 0 ? 0 : static_cast<int>(values.size())/width;
+	size_t slots = 1;
+	while (slots < 2*static_cast<size_t>(n)) {
+	    slots *= 2;
+	}
+	table.assign(slots,-1);
+	// Number the groups and count their elements, then place the
+	// positions of each group in increasing order.
+	std::vector<int> groupOf(n);
+	std::vector<int> count;
+	for (int p=0; p<n; p++) {
+	    const int* key = &values[p*width];
+	    int g = group(key);
+	    if (g < 0) {
+		g = static_cast<int>(count.size());
+		keys.insert(keys.end(),key,key+width);
+		count.push_back(0);
+		size_t k = hashValues(key,width) & (table.size()-1);
+		while (table[k] >= 0) {
+		    k = (k+1) & (table.size()-1);
+		}
+		table[k] = g;
+	    }
+	    groupOf[p] = g;
+	    count[g]++;
+	}
+	start.assign(count.size()+1,0);
+	for (size_t g=0; g<count.size(); g++) {
+	    start[g+1] = start[g]+count[g];
+	}
+	positions.resize(n);
+	std::vector<int> fill(start.begin(),start.end()-1);
+	for (int p=0; p<n; p++) {
+	    positions[fill[groupOf[p]]++] = p;
+	}
+    }
+
+    int SubsetIndex::group(const int* key) const {
+	if (table.empty() == true) {
+	    return -1;
+	}
+	size_t k = hashValues(key,width) & (table.size()-1);
+	while (table[k] >= 0) {
+	    const int* g = &keys[table[k]*width];
+	    if (std::equal(key,key+width,g) == true) {
+		return table[k];
+	    }
+	    k = (k+1) & (table.size()-1);
+	}
+	return -1;
+    }
+
+    void SubsetIndex::find(const int* key, 
+			   const int*& first, const int*& last) const {
+	const int g = group(key);
+	if (g < 0) {
+	    first = last = 0;
+	} else {
+	    first = &positions[0]+start[g];
+	    last = &positions[0]+start[g+1];
+	}
+    }
+
     void MP_set_base::display()const { 
 	//I don't like this hack.  However, until messenger is segregated from the 
 	// model, it's pretty impossible to use it in a shared fashion.
@@ -15,9 +15,12 @@
 #include <vector>
 #include <map>
 
+#include <CoinTypes.hpp>
+
 #include "MP_domain.hpp"
 #include "MP_index.hpp"
 #include "MP_utilities.hpp"
+#include "MP_parallel.hpp"
 
 namespace flopc {
 
@@ -26,8 +29,9 @@ namespace flopc {
     @note FOR INTERNAL USE: This is not normally used directly by the calling code.
 */
 class MP_set_base : public MP_index , public Named {
+    friend class DataDependencies;
 public:
-    MP_set_base() : Cyclic(false) {}
+    MP_set_base() : Cyclic(false), version(0) {}
 
     virtual int size() const = 0;
     virtual operator MP_domain() const = 0;
@@ -62,6 +66,18 @@ public:
     }
 
     bool Cyclic;
+protected:
+    /// appends this set to the subsets read by the calling thread, if
+    /// they are recorded.  @see DataReadRecorder
+    void recordRead() const {
+	std::vector<const MP_set_base*>* reads = 
+	    EvaluationContext::current().subsetReads;
+	if (reads != 0 && (reads->empty() == true || reads->back() != this)) {
+	    reads->push_back(this);
+	}
+    }
+    /// increased whenever elements are inserted, which only subsets allow
+    int version;
 };
 
     
@@ -126,6 +142,82 @@ public:
 
 template <int nbr> class MP_subset;
 
+/** @brief Hash index of the elements of a subset by their values at some
+    of the positions.
+    @ingroup INTERNAL_USE
+    @note FOR INTERNAL USE: This is not normally used directly by the
+    calling code.
+    The positions of the elements with the same values are kept together,
+    in increasing order, so they are visited in the order of the subset.
+*/
+class SubsetIndex {
+public:
+    /** indexes the elements whose values, width of them each, are
+        values[p*width] up to values[(p+1)*width] for the element at
+        position p.
+    */
+    SubsetIndex(const std::vector<int>& values, int width);
+    /** sets first and last to the range of the positions of the elements
+        with the values key[0] up to key[width].
+    */
+    void find(const int* key, const int*& first, const int*& last) const;
+private:
+    int group(const int* key) const;
+    int width;
+    /// the values of the elements of each group, width of them each
+    std::vector<int> keys;
+    /// the positions of group g are positions[start[g]] up to positions[start[g+1]]
+    std::vector<int> start;
+    std::vector<int> positions;
+    /// open addressing table of the groups, -1 for an empty slot
+    std::vector<int> table;
+};
+
+/** @brief Storage of the elements of a subset.
+    @ingroup INTERNAL_USE
+    @note FOR INTERNAL USE: This is not normally used directly by the
+    calling code.
+    Elements are numbered in the order they are inserted.  Each one is
+    packed into an integer key whose digits are its values, in bases
+    given by the sizes of the sets, and found through an open addressing
+    hash table of the element numbers.  The bases grow when a value does
+    not fit, and if the keys would overflow the values are kept instead.
+*/
+class SubsetElements {
+public:
+    SubsetElements(int width);
+    /// returns the number of the element with the values t, or outOfBound.
+    int find(const int* t) const;
+    /** inserts the element with the values t, unless present, packing
+        the values in the bases sizes, or larger ones.
+    */
+    void insert(const int* t, const int* sizes);
+    int size() const {
+	return n;
+    }
+    /// sets t to the values of element e.
+    void values(int e, int* t) const;
+    /// sets order to the element numbers in the order of their values.
+    void sort(std::vector<int>& order) const;
+private:
+    bool pack(const int* t, CoinUInt64& key) const;
+    bool same(int e, const int* t, CoinUInt64 key) const;
+    unsigned int hash(const int* t, CoinUInt64 key) const;
+    unsigned int hash(int e) const;
+    void place(int e);
+    void repack(const std::vector<int>& bases);
+    int width;
+    int n;
+    /// true if the elements are stored as keys
+    bool packed;
+    std::vector<int> base;
+    /// the keys of the elements, or their values, width of them each
+    std::vector<CoinUInt64> keys;
+    std::vector<int> tuples;
+    /// open addressing table of the element numbers, -1 for an empty slot
+    std::vector<int> table;
+};
+
 /** @brief Internal representation of a "set" 
     @ingroup INTERNAL_USE
     @note FOR INTERNAL USE: This is not normally used directly by the calling code.
@@ -161,12 +253,13 @@ template <int nbr>
 class MP_subset : public MP_set {
     friend class MP_domain_subset<nbr>;
     friend class SubsetRef<nbr>;
+    friend class DataLoader;
 public:
     MP_subset(const MP_set& s1, 
 	      const MP_set& s2=MP_set::getEmpty(), 
 	      const MP_set& s3=MP_set::getEmpty(), 
 	      const MP_set& s4=MP_set::getEmpty(), 
-	      const MP_set& s5=MP_set::getEmpty()) {
+	      const MP_set& s5=MP_set::getEmpty()) : elements(nbr) {
 	S = makeVector<nbr,const MP_set*>(&s1,&s2,&s3,&s4,&s5);
     }
 	void display(const std::string& s = "") const 
@@ -186,18 +279,32 @@ public:
 // 		}
 	}
 
-    MP_subset(std::vector<const MP_set*> s) : S(s) {}
+    MP_subset(std::vector<const MP_set*> s) : S(s), elements(nbr) {}
 
-    ~MP_subset() {}
+    /// copies the elements of s; the indexes are built again on first use.
+    MP_subset(const MP_subset& s) : 
+	MP_set(s), S(s.S), elements(s.elements) {}
 
-    int operator()(int i1, int i2=0, int i3=0, int i4=0, int i5=0) {
-	std::map<std::vector<int>, int>::const_iterator pos;
-	pos = elements.find(makeVector<nbr>(i1, i2, i3, i4, i5));
-	if (pos==elements.end()) {
-	    return outOfBound;
-	} else {
-	    return pos->second;
+    /// replaces the elements by those of s, as if they were inserted.
+    MP_subset& operator=(const MP_subset& s) {
+	if (this != &s) {
+	    const int v = version;
+	    MP_set::operator=(s);
+	    clearIndexes();
+	    S = s.S;
+	    elements = s.elements;
+	    version = v+1;
 	}
+	return *this;
+    }
+
+    ~MP_subset() {
+	clearIndexes();
+    }
+
+    int operator()(int i1, int i2=0, int i3=0, int i4=0, int i5=0) {
+	const int t[5] = {i1, i2, i3, i4, i5};
+	return find(t);
     }
 
     SubsetRef<nbr>& operator()(const MP_index_exp& i1, 
@@ -213,34 +320,47 @@ public:
     }
 
     int evaluate(const std::vector<MP_index*>& I) const {
-	std::vector<int> vi;
+	recordRead();
+	int t[nbr];
 	for (int k=0; k<nbr; k++) {
-	    int temp = I[k]->evaluate();
-	    vi.push_back(temp);
+	    t[k] = I[k]->evaluate();
 	}
-	std::map<std::vector<int>, int>::const_iterator pos;
-	pos = elements.find(vi);
-	if (pos==elements.end()) {
-	    return outOfBound;
-	} else {
-	    return pos->second;
+	return find(t);
+    }
+
+    /** returns the number of the element with the values t[0], t[1], ...
+        in turn, or outOfBound.  Elements are numbered in the order they
+        were inserted.
+    */
+    int find(const int* t) const {
+	int v[nbr];
+	for (int j=0; j<nbr; j++) {
+	    v[j] = S[j]->check(t[j]);
+	    if (v[j] == outOfBound) {
+		return outOfBound;
+	    }
 	}
+	return elements.find(v);
     }
     
+    /** inserts the element with the values args, unless it is present.
+        Values outside a cyclic set are stored as the value within it.
+    */
     void insert(const std::vector<int> &args) {
-	bool isOk = true;
+	int t[nbr];
+	int sizes[nbr];
 	for (int i=0; i<nbr; i++) {
-	    if ( S[i]->check(args[i]) == outOfBound ) {
-		isOk = false;
+	    t[i] = S[i]->check(args[i]);
+	    if (t[i] == outOfBound) {
+		return;
 	    }
+	    sizes[i] = S[i]->size();
 	}
-	if (isOk == true) {
-	    std::map<std::vector<int>, int>::const_iterator pos;
-	    pos = elements.find(args);
-	    if (pos==elements.end()) {  // insert if not existent
-		const int v = static_cast<int>(elements.size());
-		elements[args] = v;
-	    }
+	const int n = elements.size();
+	elements.insert(t,sizes);
+	if (elements.size() != n) {
+	    clearIndexes();
+	    version++;
 	}
     }
     void insert(int i1, int i2=0, int i3=0, int i4=0, int i5=0) {
@@ -254,12 +374,82 @@ public:
 	return *new InsertFunctor<nbr>(this,makeVector<nbr>(i1, i2, i3, i4, i5));
     }
     virtual int size() const {
-	return static_cast<int>(elements.size());
+	return elements.size();
+    }
+
+    /** sets first and last to the range of the positions, in the order of
+        the elements, of the elements whose values at the positions in
+        bound, a bit mask, are key[0], key[1], ... in turn.  The index of
+        the elements by those positions is built on first use.
+    */
+    void find(int bound, const int* key, 
+	      const int*& first, const int*& last) const {
+	const SubsetIndex* index;
+	{
+	    ScopedLock guard(indexLock);
+	    sort();
+	    std::map<int, SubsetIndex*>::const_iterator pos;
+	    pos = indexes.find(bound);
+	    if (pos != indexes.end()) {
+		index = pos->second;
+	    } else {
+		std::vector<int> values;
+		int t[nbr];
+		for (size_t p=0; p<ordered.size(); p++) {
+		    elements.values(ordered[p],t);
+		    for (int j=0; j<nbr; j++) {
+			if ((bound & 1<<j) != 0) {
+			    values.push_back(t[j]);
+			}
+		    }
+		}
+		int width = 0;
+		for (int j=0; j<nbr; j++) {
+		    if ((bound & 1<<j) != 0) {
+			width++;
+		    }
+		}
+		index = new SubsetIndex(values,width);
+		indexes[bound] = const_cast<SubsetIndex*>(index);
+	    }
+	}
+	index->find(key,first,last);
+    }
+    /** returns the numbers of the elements in the order of their values,
+        which domains visit them in.
+    */
+    const std::vector<int>& order() const {
+	ScopedLock guard(indexLock);
+	sort();
+	return ordered;
+    }
+    /// sets t to the values of element e.
+    void values(int e, int* t) const {
+	elements.values(e,t);
     }
 
 private:
+    /// builds ordered if elements were inserted, with indexLock held.
+    void sort() const {
+	if (static_cast<int>(ordered.size()) != elements.size()) {
+	    elements.sort(ordered);
+	}
+    }
+    void clearIndexes() {
+	std::map<int, SubsetIndex*>::iterator i;
+	for (i = indexes.begin(); i != indexes.end(); i++) {
+	    delete i->second;
+	}
+	indexes.clear();
+	ordered.clear();
+    }
     std::vector<const MP_set*> S; 
-	std::map<std::vector<int>, int> elements;
+    SubsetElements elements;
+    /// the numbers of the elements in the order of their values
+    mutable std::vector<int> ordered;
+    /// the indexes built by find(), by the positions bound
+    mutable std::map<int, SubsetIndex*> indexes;
+    mutable Mutex indexLock;
 };
 
 /** @brief Internal representation of a "set" 
@@ -332,20 +522,20 @@ private:
 	    return *this;
 	}
 
+	bool insertIndices(std::set<const MP_index*>& s) const {
+	    return I1->insertIndices(s) && I2->insertIndices(s) &&
+		I3->insertIndices(s) && I4->insertIndices(s) &&
+		I5->insertIndices(s);
+	}
+
  	int evaluate() const {
-	    std::vector<MP_index_exp> I = makeVector<nbr>(I1,I2,I3,I4,I5);
-	    std::vector<int> vi;
+	    const MP_index_exp* I[5] = {&I1, &I2, &I3, &I4, &I5};
+	    int t[nbr];
 	    for (int k=0; k<nbr; k++) {
-		int temp = I[k]->evaluate();
-		vi.push_back(temp);
-	    }
-	    std::map<std::vector<int>, int>::const_iterator pos;
-	    pos = S->elements.find(vi);
-	    if (pos==S->elements.end()) {
-		return outOfBound;
-	    } else {
-		return pos->second;
+		t[k] = (*I[k])->evaluate();
 	    }
+	    S->recordRead();
+	    return S->find(t);
 	}
 	MP_index* getIndex() const {
 	    return S;
@@ -0,0 +1,156 @@
+// ******************** FlopCpp **********************************************
+// File: MP_spill.cpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+//****************************************************************************
+
+#include <algorithm>
+
+#include <CoinError.hpp>
+#include "MP_spill.hpp"
+#include "MP_model.hpp"
+
+using namespace flopc;
+using namespace std;
+
+namespace {
+    /// read position in one run, with a buffer of its own.
+    struct RunCursor {
+	RunCursor(FILE* f, size_t n) : file(f), left(n), pos(0) {}
+	/// reads up to chunkSize more coefficients, returns false at the end.
+	bool refill(size_t chunkSize) {
+	    size_t count = std::min(chunkSize, left);
+	    if (count == 0) {
+		return false;
+	    }
+	    chunk.resize(count, Coef(0,0,0.0));
+	    if (fread(&chunk[0], sizeof(Coef), count, file) != count) {
+		throw CoinError("cannot read temporary file", "merge",
+				"CoefSpill");
+	    }
+	    left -= count;
+	    pos = 0;
+	    return true;
+	}
+	const Coef& head() const {
+	    return chunk[pos];
+	}
+	FILE* file;
+	size_t left;
+	vector<Coef> chunk;
+	size_t pos;
+    };
+
+    /// orders the heap of runs by their heads, earlier runs first on ties.
+    class HeadGreater {
+    public:
+	HeadGreater(const vector<RunCursor>& c) : C(c) {}
+	bool operator()(int a, int b) const {
+	    const Coef& x = C[a].head();
+	    const Coef& y = C[b].head();
+	    if (x.col != y.col) {
+		return x.col > y.col;
+	    } else if (x.row != y.row) {
+		return x.row > y.row;
+	    } else {
+		return a > b;
+	    }
+	}
+    private:
+	const vector<RunCursor>& C;
+    };
+}
+
+CoefSpill::CoefSpill(size_t memoryBudget) : budget(memoryBudget) {
+    // The buffer and the two permutations of its sort are in memory at
+    // the same time.
+    capacity = budget/(2*sizeof(int)+sizeof(double)+2*sizeof(int));
+    if (capacity < 1) {
+	capacity = 1;
+    }
+}
+
+CoefSpill::~CoefSpill() {
+    for (size_t k=0; k<files.size(); k++) {
+	fclose(files[k]);
+    }
+}
+
+void CoefSpill::flush() {
+    if (buffer.empty()) {
+	return;
+    }
+    // Duplicates are not merged here but by merge(), so that they are
+    // summed in the order they were added, also across runs.
+    vector<int> order;
+    MP_model::sortCoefficients(buffer,order);
+    FILE* f = tmpfile();
+    if (f == 0) {
+	throw CoinError("cannot create temporary file", "flush", "CoefSpill");
+    }
+    files.push_back(f);
+    lengths.push_back(order.size());
+    // Runs are stored as Coef records, written through a small buffer.
+    vector<Coef> chunk;
+    for (size_t k=0; k<order.size(); k+=chunk.size()) {
+	chunk.clear();
+	for (size_t l=k; l<order.size() && chunk.size()<4096; l++) {
+	    const int e = order[l];
+	    chunk.push_back(Coef(buffer.col(e),buffer.row(e),buffer.val(e),
+				 buffer.stage(e)));
+	}
+	if (fwrite(&chunk[0], sizeof(Coef), chunk.size(), f) != chunk.size()) {
+	    throw CoinError("cannot write temporary file", "flush",
+			    "CoefSpill");
+	}
+    }
+    buffer.clear();
+}
+
+void CoefSpill::merge(Sink& s) const {
+    // The read buffers share the budget of the generation buffers.
+    const size_t chunkSize = 
+	std::max<size_t>(budget/sizeof(Coef)/(files.size()+1),1);
+    vector<RunCursor> cursors;
+    vector<int> heap;
+    for (size_t k=0; k<files.size(); k++) {
+	rewind(files[k]);
+	cursors.push_back(RunCursor(files[k], lengths[k]));
+	if (cursors.back().refill(chunkSize) == true) {
+	    heap.push_back(static_cast<int>(k));
+	}
+    }
+    HeadGreater greater(cursors);
+    make_heap(heap.begin(), heap.end(), greater);
+
+    bool pending = false;
+    Coef merged(0,0,0.0);
+    while (heap.empty() == false) {
+	pop_heap(heap.begin(), heap.end(), greater);
+	RunCursor& r = cursors[heap.back()];
+	const Coef& c = r.head();
+	if (pending == true && c.col == merged.col && c.row == merged.row) {
+	    merged.val += c.val;
+	    if (c.stage > merged.stage) {
+		merged.stage = c.stage;
+	    }
+	} else {
+	    if (pending == true) {
+		s(merged);
+	    }
+	    merged = c;
+	    pending = true;
+	}
+	r.pos++;
+	if (r.pos < r.chunk.size() || r.refill(chunkSize) == true) {
+	    push_heap(heap.begin(), heap.end(), greater);
+	} else {
+	    heap.pop_back();
+	}
+    }
+    if (pending == true) {
+	s(merged);
+    }
+}
@@ -0,0 +1,74 @@
+// ******************** FlopCpp **********************************************
+// File: MP_spill.hpp
+// $Id$
+// Author: Tim Helge Hultberg (thh@mat.ua.pt)
+// Copyright (C) 2003 Tim Helge Hultberg
+// All Rights Reserved.
+// ****************************************************************************
+
+#ifndef _MP_spill_hpp_
+#define _MP_spill_hpp_
+
+#include <cstdio>
+#include <vector>
+
+#include "MP_expression.hpp"
+
+namespace flopc {
+
+    /** @brief Disk backed store of generated coefficients.
+        @ingroup INTERNAL_USE
+        @note FOR INTERNAL USE: This is not normally used directly by the
+        calling code.
+        Coefficients are collected in a buffer of bounded size.  Whenever
+        the buffer is full it is sorted by (col,row), keeping the order in
+        which duplicates were added, and written to a temporary file as a
+        sorted run.  merge() then reads the runs back in (col,row) order,
+        taking duplicates from earlier runs first, and sums them in the
+        order in which they were added, the highest stage winning, exactly
+        as MP_model::assemble() does.  No more than about memoryBudget bytes are
+        used for buffers, both while adding and while merging.  Every run
+        is kept in a file of its own, which is only read sequentially.
+    */
+    class CoefSpill {
+    public:
+	/// Receives the merged coefficients from merge().
+	class Sink {
+	public:
+	    virtual void operator()(const Coef& c) = 0;
+	    virtual ~Sink() {}
+	};
+
+	CoefSpill(size_t memoryBudget);
+	~CoefSpill();
+
+	void add(const Coef& c) {
+	    buffer.push_back(c);
+	    if (buffer.size() >= capacity) {
+		flush();
+	    }
+	}
+	/// writes the buffered coefficients as a run.
+	void flush();
+	/** calls s for every distinct (col,row) pair, in (col,row) order.
+	    flush() must be called first.  May be called more than once.
+	*/
+	void merge(Sink& s) const;
+	/// number of runs written so far.
+	int runs() const {
+	    return static_cast<int>(files.size());
+	}
+    private:
+	CoefSpill(const CoefSpill&);
+	CoefSpill& operator=(const CoefSpill&);
+
+	size_t budget;
+	size_t capacity;
+	CoefBuffer buffer;
+	std::vector<std::FILE*> files;
+	/// number of coefficients in each run.
+	std::vector<size_t> lengths;
+    };
+
+} // End of namespace flopc
+#endif
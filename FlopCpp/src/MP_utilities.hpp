@@ -11,6 +11,10 @@
 
 #include <string>
 #include <vector>
+#include <CoinTypes.hpp>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace flopc {
 
@@ -65,14 +69,15 @@ namespace flopc {
     /** Utility class to flatten multidimensional information into single
         dimentional offset information.
         @ingroup INTERNAL_USE
+        The size is 64 bit, as that of sparse data may exceed an int.
     */
     class RowMajor {
     public:
-	int size() const { return size_; }
+	CoinInt64 size() const { return size_; }
     protected:
 	RowMajor(int s1, int s2, int s3, int s4, int s5) :
 	    size1(s1), size2(s2), size3(s3), size4(s4), size5(s5),
-	    size_(s1*s2*s3*s4*s5) {}
+	    size_(static_cast<CoinInt64>(s1)*s2*s3*s4*s5) {}
 	int f(int i1=0, int i2=0, int i3=0, int i4=0, int i5=0) const {
 	    if ( i1==outOfBound || i2==outOfBound || i3==outOfBound ||
 		 i4==outOfBound || i5==outOfBound ) {
@@ -84,7 +89,8 @@ namespace flopc {
 		return i;
 	    } 
 	}
-	int size1,size2,size3,size4,size5,size_;
+	int size1,size2,size3,size4,size5;
+	CoinInt64 size_;
     };
 
     /** @brief Utility interface class for adding a string name onto a
@@ -99,6 +105,26 @@ namespace flopc {
 	std::string name;
     };
 
+    /** Adds d to i atomically and returns the new value.  Used for the
+        reference counts, so that handles to shared nodes may be copied
+        concurrently during threaded model generation.
+        @ingroup INTERNAL_USE
+     */
+    inline int atomicAdd(int& i, int d) {
+#ifdef _MSC_VER
+	return _InterlockedExchangeAdd(reinterpret_cast<volatile long*>(&i), d) + d;
+#else
+	return __sync_add_and_fetch(&i, d);
+#endif
+    }
+
+/// Storage class for data which has one instance per thread.
+#ifdef _MSC_VER
+#define FLOPC_THREAD_LOCAL __declspec(thread)
+#else
+#define FLOPC_THREAD_LOCAL __thread
+#endif
+
     /** @brief Utility for doing reference counted pointers.
         @ingroup INTERNAL_USE
      */
@@ -127,18 +153,14 @@ namespace flopc {
     protected:
 	void increment() {
 	    if(root != 0) {
-		(root->count)++;
+		atomicAdd(root->count, 1);
 	    }
 	}
 	void decrement() {
 	    if(root != 0) {
-		if(root->count == 1) {
+		if(atomicAdd(root->count, -1) == 0) {
 		    delete root;
 		    root = 0;
-		} else {
-		    ///if(root->count != 0) {
-		    --(root->count);
-		    ///}
 		}
 	    }
 	}
@@ -29,12 +29,12 @@ VariableRef::VariableRef(MP_variable* v,
 }
 
 double VariableRef::level() const {
-    return  V->M->solution[V->offset +
-			   V->f(V->S1->evaluate(),
-				V->S2->evaluate(),
-				V->S3->evaluate(),
-				V->S4->evaluate(),
-				V->S5->evaluate())];
+    return  V->M->solution[V->column(
+			       V->f(V->S1->evaluate(),
+				    V->S2->evaluate(),
+				    V->S3->evaluate(),
+				    V->S4->evaluate(),
+				    V->S5->evaluate()))];
 }
 
 int VariableRef::getColumn() const { 
@@ -45,20 +45,24 @@ int VariableRef::getColumn() const {
     int i5 = V->S5->check(I5->evaluate());
     
     if (i1==outOfBound || i2==outOfBound || i3==outOfBound ||
-	i4==outOfBound || i5==outOfBound) {
+	i4==outOfBound || i5==outOfBound || i1>=V->active ||
+	i1<V->firstGenerated) {
 	return outOfBound;
     } else {
-	return V->offset +  V->f(i1,i2,i3,i4,i5);
+	return V->column(V->f(i1,i2,i3,i4,i5));
     }
 }
 
 void VariableRef::generate(const MP_domain& domain,
-			   vector<Constant > multiplicators,
+			   MultiplicatorStack& multiplicators,
 			   GenerateFunctor& f,
 			   double m)  const {
+    if (f.only != 0 && f.only != V) {
+	return;
+    }
     f.setMultiplicator(multiplicators,m);
     f.setTerminalExpression(this);
-    domain.Forall(&f);
+    f.forall(domain);
 }
  
 MP_variable::MP_variable(const MP_set_base &s1, 
@@ -70,7 +74,7 @@ MP_variable::MP_variable(const MP_set_base &s1,
     upperLimit(MP_data(s1,s2,s3,s4,s5)),
     lowerLimit(MP_data(s1,s2,s3,s4,s5)),
     S1(&s1),S2(&s2),S3(&s3),S4(&s4),S5(&s5),
-    offset(-1)
+    offset(-1), active(s1.size()), firstGenerated(0)
 {
     lowerLimit.initialize(0.0);
     upperLimit.initialize(MP_model::getDefaultModel().getInfinity());
@@ -78,21 +82,32 @@ MP_variable::MP_variable(const MP_set_base &s1,
 }    
 
 double MP_variable::level(int lcl_i1, int lcl_i2, int lcl_i3, int lcl_i4, int lcl_i5) {
-    return M->solution[offset +  f(lcl_i1,lcl_i2,lcl_i3,lcl_i4,lcl_i5)];
+    if (lcl_i1 >= active) {
+	return 0.0;
+    }
+    return M->solution[column(f(lcl_i1,lcl_i2,lcl_i3,lcl_i4,lcl_i5))];
+}
+
+void MP_variable::setActive(int n) {
+    active = (n < 0) ? 0 : ((n > size1) ? size1 : n);
+    size_ = active*size2*size3*size4*size5;
 }
 
 void MP_variable::operator()() const {
+    if (i1.evaluate() >= active) {
+	return;
+    }
     if (S1!=&MP_set::getEmpty()) cout << i1.evaluate() << " ";
     if (S2!=&MP_set::getEmpty()) cout << i2.evaluate() << " ";
     if (S3!=&MP_set::getEmpty()) cout << i3.evaluate() << " ";
     if (S4!=&MP_set::getEmpty()) cout << i4.evaluate() << " ";
     if (S5!=&MP_set::getEmpty()) cout << i5.evaluate() << " ";
-    cout<<"  "<< M->solution[offset +
-			     f(i1.evaluate(),
-			       i2.evaluate(),
-			       i3.evaluate(),
-			       i4.evaluate(),
-			       i5.evaluate())]<<endl;
+    cout<<"  "<< M->solution[column(
+				 f(i1.evaluate(),
+				   i2.evaluate(),
+				   i3.evaluate(),
+				   i4.evaluate(),
+				   i5.evaluate()))]<<endl;
 }
 
 void MP_variable::display(const std::string &s) {
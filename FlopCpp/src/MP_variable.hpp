@@ -34,6 +34,7 @@ namespace flopc {
      */
     class VariableRef : public TerminalExpression {
 	friend class MP_variable;
+	friend class CompiledConstraint;
     public:
 	int getColumn() const;
     private:
@@ -55,8 +56,11 @@ namespace flopc {
 	int getStage() const { 
 	    return 0;
 	}
+	const VariableRef* getVariableRef() const {
+	    return this;
+	}
 	void generate(const MP_domain& domain,
-		      std::vector<Constant> multiplicators,
+		      MultiplicatorStack& multiplicators,
 		      GenerateFunctor& f,
 		      double m) const;
 	MP_variable* V;
@@ -76,6 +80,7 @@ namespace flopc {
 	friend class MP_model;
 	friend class DisplayVariable;
 	friend class VariableRef;
+	friend class CompiledConstraint;
     public:
 	MP_variable(const MP_set_base &s1 = MP_set::getEmpty(), 
 		    const MP_set_base &s2 = MP_set::getEmpty(), 
@@ -114,6 +119,29 @@ namespace flopc {
 	void integer() { 
 	    type = discrete; 
 	}
+
+    /** Makes only the elements whose first index is below n columns of
+        the model.  The others can be added later, e.g. while generating
+        columns, with MP_model::addColumns().  By default all elements are
+        columns.
+     */
+	void setActive(int n);
+    /// Returns the number of values of the first index which are columns.
+	int getActive() const {
+	    return active;
+	}
+
+    /// Internal use only: the column of the element at position l.
+	int column(int l) const {
+	    if (added.empty() == true || l < added.front().first) {
+		return offset + l;
+	    }
+	    size_t k = added.size()-1;
+	    while (l < added[k].first) {
+		k--;
+	    }
+	    return added[k].second + l - added[k].first;
+	}
  
     /// Upper bound on the variable value.
 	MP_data upperLimit;
@@ -127,6 +155,13 @@ namespace flopc {
 	MP_model *M;
 	variableType type;
 	int offset;
+	int active;
+	/// only the elements whose first index is at least this get columns
+	/// while generating, see MP_model::addColumns()
+	int firstGenerated;
+	/// the first element and the first column of every batch of columns
+	/// added by MP_model::addColumns() since the model was loaded
+	std::vector<std::pair<int,int> > added;
     };
 
     /** Specialized subclass of MP_variable where the variable is
@@ -14,6 +14,7 @@
 #include "MP_index.hpp"
 #include "MP_constant.hpp"
 #include "MP_data.hpp"
+#include "MP_loader.hpp"
 #include "MP_constraint.hpp"
 #include "MP_expression.hpp"
 #include "MP_boolean.hpp"
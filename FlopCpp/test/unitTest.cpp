@@ -4,12 +4,161 @@ using namespace flopc;
 using namespace std;
 #include "OsiCbcSolverInterface.hpp"
 #include "CoinFloatEqual.hpp"
+#include "CoinWarmStartBasis.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 
 namespace Aircraft {
     enum {a, b, c, d, numA};
 } 
 
+namespace {
+    // counts how a model is loaded into and updated in the solver.
+    class CountingSolver : public OsiCbcSolverInterface {
+    public:
+	CountingSolver() : loaded(0), modified(0), rowBounds(0), 
+			   objCoeffs(0), addedRows(0) {}
+	void loadProblem(const CoinPackedMatrix& matrix, 
+			 const double* collb, const double* colub,
+			 const double* obj, 
+			 const double* rowlb, const double* rowub) {
+	    loaded++;
+	    OsiCbcSolverInterface::loadProblem(matrix,collb,colub,obj,
+					       rowlb,rowub);
+	}
+	void assignProblem(CoinPackedMatrix*& matrix, 
+			   double*& collb, double*& colub, double*& obj, 
+			   double*& rowlb, double*& rowub) {
+	    loaded++;
+	    OsiCbcSolverInterface::assignProblem(matrix,collb,colub,obj,
+						 rowlb,rowub);
+	}
+	void modifyCoefficient(int row, int column, double newElement, 
+			       bool keepSorted=true) {
+	    modified++;
+	    OsiCbcSolverInterface::modifyCoefficient(row,column,newElement,
+						     keepSorted);
+	}
+	void setRowBounds(int elementIndex, double lower, double upper) {
+	    rowBounds++;
+	    OsiCbcSolverInterface::setRowBounds(elementIndex,lower,upper);
+	}
+	void setObjCoeff(int elementIndex, double elementValue) {
+	    objCoeffs++;
+	    OsiCbcSolverInterface::setObjCoeff(elementIndex,elementValue);
+	}
+	void addRows(const int numrows, const CoinBigIndex* rowStarts,
+		     const int* columns, const double* element,
+		     const double* rowlb, const double* rowub) {
+	    addedRows++;
+	    OsiCbcSolverInterface::addRows(numrows,rowStarts,columns,element,
+					   rowlb,rowub);
+	}
+	int loaded;
+	int modified;
+	int rowBounds;
+	int objCoeffs;
+	int addedRows;
+    };
+
+    // a status other than atLowerBound, the default of a new column, and
+    // basic, the default of a new row, which depends on v alone.
+    CoinWarmStartBasis::Status statusOf(double v) {
+	switch (static_cast<int>(v) % 2) {
+	case 0:
+	    return CoinWarmStartBasis::atUpperBound;
+	default:
+	    return CoinWarmStartBasis::isFree;
+	}
+    }
+
+    // reports the status of every column by its objective coefficient and
+    // of every row by its finite bound, and keeps the last basis set.
+    class BasisSolver : public OsiCbcSolverInterface {
+    public:
+	CoinWarmStart* getWarmStart() const {
+	    CoinWarmStartBasis* basis = new CoinWarmStartBasis;
+	    basis->setSize(getNumCols(),getNumRows());
+	    for (int j=0; j<getNumCols(); j++) {
+		basis->setStructStatus(j,statusOf(getObjCoefficients()[j]));
+	    }
+	    for (int i=0; i<getNumRows(); i++) {
+		basis->setArtifStatus(i,statusOf(rowBound(i)));
+	    }
+	    return basis;
+	}
+	bool setWarmStart(const CoinWarmStart* warmstart) {
+	    const CoinWarmStartBasis* basis = 
+		dynamic_cast<const CoinWarmStartBasis*>(warmstart);
+	    if (basis != 0) {
+		restored = *basis;
+	    }
+	    return OsiCbcSolverInterface::setWarmStart(warmstart);
+	}
+	double rowBound(int i) const {
+	    return getRowLower()[i] > -getInfinity() ? getRowLower()[i] :
+		getRowUpper()[i];
+	}
+	CoinWarmStartBasis restored;
+    };
+
+    // true if the two solvers hold the same problem, value for value.
+    bool sameProblem(OsiSolverInterface* s1, OsiSolverInterface* s2) {
+	const int m = s1->getNumRows();
+	const int n = s1->getNumCols();
+	if (m != s2->getNumRows() || n != s2->getNumCols() ||
+	    s1->getNumElements() != s2->getNumElements()) {
+	    return false;
+	}
+	for (int i=0; i<m; i++) {
+	    if (s1->getRowLower()[i] != s2->getRowLower()[i] ||
+		s1->getRowUpper()[i] != s2->getRowUpper()[i]) {
+		return false;
+	    }
+	}
+	const CoinPackedMatrix* a1 = s1->getMatrixByCol();
+	const CoinPackedMatrix* a2 = s2->getMatrixByCol();
+	for (int j=0; j<n; j++) {
+	    if (s1->getColLower()[j] != s2->getColLower()[j] ||
+		s1->getColUpper()[j] != s2->getColUpper()[j] ||
+		s1->getObjCoefficients()[j] != s2->getObjCoefficients()[j]) {
+		return false;
+	    }
+	    vector<pair<int,double> > c1, c2;
+	    for (int k=0; k<a1->getVectorLengths()[j]; k++) {
+		const CoinBigIndex e = a1->getVectorStarts()[j]+k;
+		c1.push_back(make_pair(a1->getIndices()[e],
+				       a1->getElements()[e]));
+	    }
+	    for (int k=0; k<a2->getVectorLengths()[j]; k++) {
+		const CoinBigIndex e = a2->getVectorStarts()[j]+k;
+		c2.push_back(make_pair(a2->getIndices()[e],
+				       a2->getElements()[e]));
+	    }
+	    sort(c1.begin(),c1.end());
+	    sort(c2.begin(),c2.end());
+	    if (c1 != c2) {
+		return false;
+	    }
+	}
+	return true;
+    }
+
+    // a task of a WorkerPool, which throws if told to.
+    class ThrowingTask : public Functor {
+    public:
+	ThrowingTask() : throws(false) {}
+	void operator()() const {
+	    if (throws == true) {
+		throw CoinError("task failed", "operator()", "ThrowingTask");
+	    }
+	}
+	bool throws;
+    };
+}
+
 int main() {
 
   /*The objective of this model is to allocate aircrafts to routes to maximize
@@ -166,6 +315,431 @@ int main() {
 
     y.display("y second model");
   }
+
+  // COLUMNS generation gives the same problem as TRIPLETS, with duplicates
+  // merged in place and constants on both sides moved to the bounds.
+  {
+    MP_model m1(new OsiCbcSolverInterface), m2(new OsiCbcSolverInterface);
+    MP_set i(4), j(3);
+    MP_variable x(i,j), y(i);
+    MP_constraint c1(i), c2(j), c3;
+    c1(i) = sum(j, x(i,j) + 0.1*x(i,j)) + 0.2*y(i) + 3 <=
+      0.3*y(i) + 0.4*y(i) - 2;
+    c2(j) = sum(i, x(i,j)) + 1.5 >= sum(i, 0.7*x(i,j)) - 0.5;
+    c3() = sum(i, y(i)) - 2*sum(i, y(i)) == 4;
+
+    m1.add(c1).add(c2).add(c3);
+    m1.minimize(sum(i, y(i)));
+    m2.setGeneration(MP_model::COLUMNS);
+    m2.add(c1).add(c2).add(c3);
+    m2.minimize(sum(i, y(i)));
+
+    assert(m1->getNumElements()==4*3*2+4+4);
+    assert(m1->getRowUpper()[0]==-5);
+    assert(sameProblem(m1.operator->(), m2.operator->()));
+  }
+
+  // STREAMING generation through many small runs gives the same problem as
+  // TRIPLETS: duplicates are summed in the order they were generated.
+  {
+    MP_model m1(new OsiCbcSolverInterface), m2(new OsiCbcSolverInterface);
+    MP_set i(2);
+    MP_variable v(i), w(i);
+    MP_constraint c(i);
+    c(i) = v(i) + 0.1*w(i) + 0.2*w(i) + 0.3*w(i) <= 1;
+
+    m1.add(c);
+    m1.minimize(sum(i, v(i)+w(i)));
+    assert(m1->getNumElements()==4);
+    m2.add(c);
+    m2.setGeneration(MP_model::STREAMING);
+    for (size_t budget=24; budget<=240; budget+=8) {
+      m2.setGenerationMemory(budget);
+      m2.minimize(sum(i, v(i)+w(i)));
+      assert(sameProblem(m1.operator->(), m2.operator->()));
+    }
+  }
+  // Constraint blocks generated on several threads give the same problem
+  // as the serial generation.
+  {
+    MP_model m1(new OsiCbcSolverInterface), m2(new OsiCbcSolverInterface);
+    MP_set i(7), j(5);
+    double aval[7][5], bval[7];
+    for (int r=0; r<7; r++) {
+      for (int s=0; s<5; s++) {
+        aval[r][s] = 0.1*r + 0.3*s + 0.7;
+      }
+      bval[r] = r + 2;
+    }
+    MP_data a(&aval[0][0],i,j), b(bval,i);
+    MP_variable x(i,j), y(i), z;
+    MP_constraint c1(i), c2(j), c3(i,j), c4;
+    c1(i) = sum(j, a(i,j)*x(i,j)) + y(i) <= b(i);
+    c2(j) = sum(i, a(i,j)*x(i,j)) >= 1;
+    c3(i,j) = x(i,j) + 0.1*y(i) + 0.2*y(i) <= a(i,j)*z();
+    c4() = sum(i, b(i)*y(i)) == z();
+    x.upperLimit(i,j) = b(i);
+
+    m1.add(c1).add(c2).add(c3).add(c4);
+    m1.minimize(sum(i*j, a(i,j)*x(i,j)) + z());
+    m2.setGenerationThreads(4);
+    m2.add(c1).add(c2).add(c3).add(c4);
+    m2.minimize(sum(i*j, a(i,j)*x(i,j)) + z());
+
+    assert(m1->getNumRows()==7+5+35+1);
+    assert(sameProblem(m1.operator->(), m2.operator->()));
+  }
+  // Compiled constraint blocks give the same problem as the tree walk,
+  // with and without checking, including a cyclic shift, a condition and
+  // a block over a subset, which is still walked.
+  {
+    MP_model m1(new OsiCbcSolverInterface), m2(new OsiCbcSolverInterface),
+      m3(new OsiCbcSolverInterface);
+    MP_set i(6), j(4), t(5);
+    t.cyclic();
+    MP_subset<2> L(i,j);
+    L.insert(0,3);
+    L.insert(2,1);
+    L.insert(5,0);
+    double aval[6][4];
+    for (int r=0; r<6; r++) {
+      for (int s=0; s<4; s++) {
+        aval[r][s] = 0.25*r - 0.5*s + 1;
+      }
+    }
+    MP_data a(&aval[0][0],i,j);
+    MP_variable x(i,j), y(t), z;
+    MP_constraint c1(i), c2(j), c3(t), c4(i);
+    c1(i) = sum(j, a(i,j)*x(i,j)) + z() <= 10;
+    c2(j) = sum(i.such_that(a(i,j) > 1), x(i,j)) >= 1;
+    c3(t) = y(t) - 0.5*y(t+1) + 2*y(t-2) >= 1;
+    c4(i) = sum(L(i,j), 3*x(i,j)) + z() <= a(i,0);
+
+    m1.add(c1).add(c2).add(c3).add(c4);
+    m1.minimize(sum(i*j, x(i,j)) + sum(t, y(t)));
+    m2.setCompiledGeneration(true);
+    m2.add(c1).add(c2).add(c3).add(c4);
+    m2.minimize(sum(i*j, x(i,j)) + sum(t, y(t)));
+    assert(m2.getCompiledGeneration()==true);
+    assert(sameProblem(m1.operator->(), m2.operator->()));
+
+    // checking warns of any difference between the two.
+    stringstream warnings;
+    streambuf* console = cout.rdbuf(warnings.rdbuf());
+    m3.setCompiledGeneration(true, true);
+    m3.add(c1).add(c2).add(c3).add(c4);
+    m3.minimize(sum(i*j, x(i,j)) + sum(t, y(t)));
+    cout.rdbuf(console);
+    assert(warnings.str().find("Warning")==string::npos);
+    assert(sameProblem(m1.operator->(), m3.operator->()));
+
+    m2.setCompiledGeneration(false);
+    m2.minimize(sum(i*j, x(i,j)) + sum(t, y(t)));
+    assert(sameProblem(m1.operator->(), m2.operator->()));
+  }
+  // A task throwing, on a worker or on the calling thread, stops the
+  // pool, which throws once every worker is done.
+  for (int threads=1; threads<=4; threads+=3) {
+    for (int pass=0; pass<20; pass++) {
+      ThrowingTask tasks[40];
+      vector<const Functor*> list;
+      for (int k=0; k<40; k++) {
+	tasks[k].throws = (k%10 == 9);
+	list.push_back(&tasks[k]);
+      }
+      WorkerPool pool(threads);
+      bool caught = false;
+      try {
+	pool.run(list);
+      } catch (CoinError& e) {
+	caught = (e.message() == "task failed");
+      }
+      assert(caught);
+    }
+  }
+
+  // An incrementally attached model is updated in place, without loading
+  // it again, when subsets, data or the objective change, and ends up
+  // with the problem a full load gives.
+  {
+    CountingSolver* s = new CountingSolver;
+    MP_model m1(s);
+    MP_set i(3), j(3);
+    MP_subset<2> L(i,j);
+    L.insert(0,0);
+    L.insert(1,2);
+    double aval[3] = {1, 2, 3};
+    MP_data a(aval,i), b(i);
+    b(i) = 4;
+    MP_variable x(i,j);
+    MP_constraint c(i);
+    c(i) = sum(L(i,j), a(i)*x(i,j)) <= b(i);
+
+    m1.setIncrementalAttach(true);
+    m1.add(c);
+    m1.minimize(sum(i*j, x(i,j)));
+    assert(s->loaded==1 && s->getNumElements()==2);
+
+    L.insert(2,2);
+    L.insert(0,1);
+    m1.minimize(sum(i*j, x(i,j)));
+    assert(s->loaded==1 && s->modified==2 && s->getNumElements()==4);
+
+    a(1) = 5;
+    b(0) = 7;
+    m1.minimize(sum(i*j, x(i,j)));
+    assert(s->loaded==1 && s->modified==3 && s->rowBounds==1);
+
+    m1.minimize(sum(i*j, 2*x(i,j)));
+    assert(s->loaded==1 && s->objCoeffs==9);
+
+    MP_model m2(new OsiCbcSolverInterface);
+    m2.add(c);
+    m2.minimize(sum(i*j, 2*x(i,j)));
+    assert(sameProblem(s, m2.operator->()));
+  }
+
+  // Reading data does not count as changing it, so an incrementally
+  // attached model regenerates only blocks whose data are written.
+  {
+    ProfilingMessenger* p = new ProfilingMessenger;
+    MP_model m1(new OsiCbcSolverInterface, p);
+    MP_set i(3);
+    MP_data a(i);
+    a(i) = 2;
+    MP_variable x(i);
+    MP_constraint c(i);
+    c(i) = a(i)*x(i) <= 1;
+    m1.setIncrementalAttach(true);
+    m1.add(c);
+    m1.minimize(sum(i, x(i)));
+    for (int pass=0; pass<2; pass++) {
+      const double before = a(1);
+      if (pass == 1) {
+        a(1) += 1;
+      }
+      m1.minimize(sum(i, x(i)));
+      size_t blocks = 0;
+      for (size_t k=0; k<p->getProfiles().size(); k++) {
+        if (p->getProfiles()[k].objective == false) {
+          blocks++;
+        }
+      }
+      assert(blocks==static_cast<size_t>(pass));
+      assert(a(1)==before+pass);
+    }
+  }
+
+  // A constraint block added to the attached model is added with one call
+  // of the solver, after the rows loaded, where price() finds it.
+  {
+    CountingSolver* s = new CountingSolver;
+    MP_model m1(s);
+    MP_set i(3), j(2);
+    double wval[3] = {1, 2, 3};
+    MP_data w(wval,i);
+    MP_variable x(i,j);
+    MP_constraint c1(i);
+    // c2 is made in another model, so that it is added to m1 only later.
+    MP_model m2(0);
+    MP_constraint c2(j);
+    c1(i) = sum(j, x(i,j)) <= 1;
+    c2(j) = sum(i, w(i)*x(i,j)) >= 2;
+
+    m1.minimize(sum(i*j, x(i,j)));
+    assert(s->getNumRows()==3);
+    m1.addRows(c2);
+    assert(s->loaded==1 && s->addedRows==1);
+    assert(s->getNumRows()==5 && s->getNumElements()==12);
+    assert(s->getRowLower()[3]==2 && s->getRowLower()[4]==2);
+
+    m1.solve(MP_model::MINIMIZE);
+    for (int k=0; k<3; k++) {
+      assert(c1.price(k)==s->getRowPrice()[k]);
+    }
+    for (int k=0; k<2; k++) {
+      assert(c2.price(k)==s->getRowPrice()[3+k]);
+    }
+  }
+
+  // Columns added to the attached model get the coefficients, objective
+  // and bounds of the new elements of the variable, and their levels.
+  {
+    MP_model m1(new OsiCbcSolverInterface);
+    MP_set i(4), j(2);
+    double aval[4][2] = {{1, 2}, {3, 4}, {5, 6}, {7, 8}};
+    double cval[4][2] = {{11, 12}, {13, 14}, {15, 16}, {17, 18}};
+    MP_data a(&aval[0][0],i,j), cost(&cval[0][0],i,j);
+    MP_variable x(i,j), y(j);
+    MP_constraint c(j);
+    c(j) = sum(i, a(i,j)*x(i,j)) + y(j) >= 1;
+    x.upperLimit(i,j) = 2*a(i,j);
+
+    x.setActive(2);
+    m1.minimize(sum(i*j, cost(i,j)*x(i,j)) + sum(j, y(j)));
+    assert(m1->getNumCols()==6 && m1->getNumElements()==6);
+
+    m1.addColumns(x,1);
+    assert(m1->getNumCols()==8 && m1->getNumElements()==8);
+    const CoinPackedMatrix* A = m1->getMatrixByCol();
+    for (int k=0; k<2; k++) {
+      const int col = 6+k;
+      assert(m1->getObjCoefficients()[col]==cval[2][k]);
+      assert(m1->getColLower()[col]==0 && 
+	     m1->getColUpper()[col]==2*aval[2][k]);
+      assert(A->getVectorLengths()[col]==1);
+      assert(A->getIndices()[A->getVectorStarts()[col]]==k);
+      assert(A->getElements()[A->getVectorStarts()[col]]==aval[2][k]);
+    }
+
+    m1.solve(MP_model::MINIMIZE);
+    for (int k=0; k<2; k++) {
+      assert(x.level(2,k)==m1->getColSolution()[6+k]);
+      assert(x.level(3,k)==0);
+    }
+  }
+
+  // The basis is kept across loads, by the indices of the rows and
+  // columns, when variables grow or shrink and blocks are added.
+  {
+    BasisSolver* s = new BasisSolver;
+    MP_model m1(s);
+    MP_set i(4), j(2);
+    double cval[4][2] = {{2, 3}, {4, 5}, {7, 9}, {10, 11}};
+    double dval[2] = {6, 7};
+    double eval[4] = {12, 13, 14, 15};
+    MP_data cost(&cval[0][0],i,j), d(dval,j), e(eval,i);
+    MP_variable x(i,j), y(j);
+    MP_constraint c1(j);
+    // c2 is made in another model, so that it is added to m1 only later.
+    MP_model m2(0);
+    MP_constraint c2(i);
+    c1(j) = sum(i, x(i,j)) - y(j) >= d(j);
+    c2(i) = sum(j, x(i,j)) <= e(i);
+
+    m1.setKeepBasis(true);
+    x.setActive(3);
+    m1.minimize(sum(i*j, cost(i,j)*x(i,j)) + sum(j, 20*y(j)));
+    assert(s->getNumCols()==8 && s->getNumRows()==2);
+
+    // x grows by x(3,j), with costs 10 and 11, and the rows of c2, with
+    // upper bounds 12 to 15, are added.
+    x.setActive(4);
+    m1.add(c2);
+    m1.minimize(sum(i*j, cost(i,j)*x(i,j)) + sum(j, 20*y(j)));
+    assert(s->getNumCols()==10 && s->getNumRows()==6);
+    for (int k=0; k<s->getNumCols(); k++) {
+      const double o = s->getObjCoefficients()[k];
+      assert(s->restored.getStructStatus(k)==(o >= 10 && o <= 11 ? 
+	     CoinWarmStartBasis::atLowerBound : statusOf(o)));
+    }
+    for (int k=0; k<s->getNumRows(); k++) {
+      const double b = s->rowBound(k);
+      assert(s->restored.getArtifStatus(k)==(b >= 12 ? 
+	     CoinWarmStartBasis::basic : statusOf(b)));
+    }
+
+    // x shrinks, and all that is left keeps its status.
+    x.setActive(2);
+    m1.minimize(sum(i*j, cost(i,j)*x(i,j)) + sum(j, 20*y(j)));
+    assert(s->getNumCols()==6 && s->getNumRows()==6);
+    for (int k=0; k<s->getNumCols(); k++) {
+      assert(s->restored.getStructStatus(k)==
+	     statusOf(s->getObjCoefficients()[k]));
+    }
+    for (int k=0; k<s->getNumRows(); k++) {
+      assert(s->restored.getArtifStatus(k)==statusOf(s->rowBound(k)));
+    }
+  }
+
+  // Sparse data with the default value 0 drives the generation of the
+  // terms it multiplies over the values stored alone; with another
+  // default value every element is visited.
+  {
+    ProfilingMessenger* p = new ProfilingMessenger;
+    MP_model m1(new OsiCbcSolverInterface, p);
+    MP_set i(40), j(50);
+    MP_sparse_data a(i,j);
+    a(3,7) = 2.0;
+    a(20,1) = 5.0;
+    MP_variable x(i,j);
+    MP_constraint c(i);
+    c(i) = sum(j, a(i,j)*x(i,j)) <= 1;
+    for (int pass=0; pass<2; pass++) {
+      m1.minimize(sum(i*j, x(i,j)));
+      const vector<GenerationProfile>& profiles = p->getProfiles();
+      size_t tuples = 0;
+      for (size_t k=0; k<profiles.size(); k++) {
+	if (profiles[k].objective == false) {
+	  tuples += profiles[k].tuples;
+	}
+      }
+      // the right hand side adds one element per row.
+      assert(tuples==(pass == 0 ? 2+40 : 40*50+40));
+      a.initialize(1.0);
+      a(3,7) = 2.0;
+    }
+  }
+
+  // Assembly sums duplicates in the order they were generated, keeps the
+  // highest stage, and orders by column and row, both when sorting in
+  // linear time and with few coefficients over many columns.
+  for (int path=0; path<2; path++) {
+    const int spread = (path == 0) ? 1 : 1000000;
+    CoefBuffer v, av;
+    v.push_back(3*spread,1,0.1,1);
+    v.push_back(0,2,1.0,0);
+    v.push_back(3*spread,1,0.2,3);
+    v.push_back(3*spread,0,5.0,0);
+    v.push_back(0,0,2.0,0);
+    v.push_back(3*spread,1,0.3,2);
+    v.push_back(0,2,-1.0,0);
+    MP_model::assemble(v,av);
+
+    assert(av.size()==4);
+    assert(av.col(0)==0 && av.row(0)==0 && av.val(0)==2.0);
+    assert(av.col(1)==0 && av.row(1)==2 && av.val(1)==0.0);
+    assert(av.col(2)==3*spread && av.row(2)==0 && av.val(2)==5.0);
+    assert(av.col(3)==3*spread && av.row(3)==1);
+    assert(av.val(3)==(0.1+0.2)+0.3 && av.val(3)!=0.1+(0.2+0.3));
+    assert(av.stage(3)==3);
+  }
+
+  // An objective constant becomes the right hand side of the objective
+  // row, with the opposite sign.
+  {
+    MP_model m1(0);
+    MP_set i(2);
+    MP_variable x(i);
+    MP_constraint c(i);
+    c(i) = x(i) >= 1;
+    m1.setObjective(sum(i, 2*x(i)) + 7);
+    m1.generateMps("unitTest.mps");
+
+    ifstream in("unitTest.mps");
+    stringstream file;
+    file<<in.rdbuf();
+    in.close();
+    remove("unitTest.mps");
+    assert(file.str()==
+	   "NAME  FlopCpp\n"
+	   "ROWS\n"
+	   " N  OBJ\n"
+	   " G  R0\n"
+	   " G  R1\n"
+	   "COLUMNS\n"
+	   "    C0  OBJ  2\n"
+	   "    C0  R0  1\n"
+	   "    C1  OBJ  2\n"
+	   "    C1  R1  1\n"
+	   "RHS\n"
+	   "    RHS  OBJ  -7\n"
+	   "    RHS  R0  1\n"
+	   "    RHS  R1  1\n"
+	   "BOUNDS\n"
+	   "ENDATA\n");
+  }
+
   cout<<"All tests completed successfully"<<endl;
 
 }
@@ -3,6 +3,40 @@
 #include "MP_set.hpp"
 #include "MP_boolean.hpp"
 #include "MP_constant.hpp"
+#include "MP_domain.hpp"
+
+namespace {
+    // Keeps the elements whose index value is a multiple of m, and counts
+    // how often it was evaluated.
+    class CountingCondition : public flopc::Boolean_base {
+    public:
+	CountingCondition(const flopc::MP_index& i, int m) : 
+	    I(i), M(m), evaluations(0) {}
+	bool evaluate() const {
+	    evaluations++;
+	    return I.evaluate()%M == 0;
+	}
+	bool insertIndices(std::set<const flopc::MP_index*>& s) const {
+	    s.insert(&I);
+	    return true;
+	}
+	int references() const {
+	    return count;
+	}
+	const flopc::MP_index& I;
+	int M;
+	mutable int evaluations;
+    };
+
+    class CountingFunctor : public flopc::Functor {
+    public:
+	CountingFunctor() : visits(0) {}
+	void operator()() const {
+	    visits++;
+	}
+	mutable int visits;
+    };
+}
 
 bool booleanTest()
 {
@@ -80,6 +114,73 @@ bool booleanTest()
 
 
 
+    // Walking a filtered domain again visits the same elements, and keeps
+    // no copy of its conditions behind.
+    {
+	flopc::MP_set I(4), J(5);
+	flopc::MP_index i, j;
+	CountingCondition* c = new CountingCondition(i,2);
+	flopc::MP_boolean cond(c);
+	flopc::MP_domain d = (I(i)*J(j)).such_that(cond);
+	const int held = c->references();
+	for (int walk=0; walk<3; walk++) {
+	    CountingFunctor f;
+	    d.Forall(&f);
+	    if(f.visits!=2*5)
+	    {ti->failItem(__SPOT__);return false;}
+	    if(c->references()!=held)
+	    {ti->failItem(__SPOT__);return false;}
+	}
+    }
+
+    // A condition on the outer index alone is checked once per outer
+    // element and prunes the inner loop; a condition on the inner index
+    // is checked for every element.
+    {
+	flopc::MP_set I(4), J(5);
+	flopc::MP_index i, j;
+	CountingCondition* outer = new CountingCondition(i,2);
+	CountingCondition* inner = new CountingCondition(j,3);
+	flopc::MP_boolean onI(outer), onJ(inner);
+
+	CountingFunctor f1;
+	(I(i)*J(j)).such_that(onI).Forall(&f1);
+	if(f1.visits!=2*5 || outer->evaluations!=4)
+	{ti->failItem(__SPOT__);return false;}
+
+	CountingFunctor f2;
+	(I(i)*J(j)).such_that(onJ).Forall(&f2);
+	if(f2.visits!=4*2 || inner->evaluations!=4*5)
+	{ti->failItem(__SPOT__);return false;}
+
+	outer->evaluations = 0;
+	inner->evaluations = 0;
+	CountingFunctor f3;
+	(I(i)*J(j)).such_that(onI).such_that(onJ).Forall(&f3);
+	if(f3.visits!=2*2 || outer->evaluations!=4 || 
+	   inner->evaluations!=2*5)
+	{ti->failItem(__SPOT__);return false;}
+    }
+
+    // A condition on the outer index is checked once per outer element
+    // also when the inner level is a subset over both indices.
+    {
+	flopc::MP_set I(10), J(10);
+	flopc::MP_subset<2> L(I,J);
+	for (int a=0; a<10; a++) {
+	    for (int b=0; b<10; b++) {
+		L.insert(a,b);
+	    }
+	}
+	flopc::MP_index i, j;
+	CountingCondition* outer = new CountingCondition(i,2);
+	flopc::MP_boolean onI(outer);
+	CountingFunctor f;
+	(I(i)*L(i,j)).such_that(onI).Forall(&f);
+	if(f.visits!=5*10 || outer->evaluations!=10)
+	{ti->failItem(__SPOT__);return false;}
+    }
+
     /** @TODO finish out these tests.
     MP_boolean operator<=(const MP_index_exp& e1, const MP_index_exp& e2) {
 	return new Boolean_lessEq(e1, e2);
@@ -3,8 +3,12 @@
 #include "MP_index.hpp"
 #include "MP_set.hpp"
 #include "MP_data.hpp"
+#include "MP_loader.hpp"
 #include "TestItem.hpp"
+#include <CoinError.hpp>
+#include <cstdio>
 #include <iostream>
+#include <sstream>
 
 bool constantTest() {
     TestItem *ti = new TestItem("flopc:constantTest");
@@ -97,6 +101,216 @@ bool constantTest() {
     if(flopc::abs(myData(1))->evaluate()!=2.0)
     {ti->failItem(__SPOT__); return false;}
 
+    // sparse data: only the values assigned are stored, the others
+    // having the default value.
+    flopc::MP_sparse_data sparseData(mySet,mySet);
+    sparseData.initialize(-1.0);
+    sparseData(i,1) = 2.0;
+    sparseData(2,1) = 4.0;
+    if(flopc::Constant(sparseData(0,2))->evaluate()!=-1.0 ||
+       flopc::sum(mySet(i)*mySet(j),sparseData(i,j))->evaluate()!=2.0)
+    {ti->failItem(__SPOT__); return false;}
+
+    // looking values up stores nothing; writing through the element
+    // stores the value written.
+    {
+	flopc::MP_sparse_data looked(mySet,mySet);
+	double read = looked(0,0) + looked(1,2);
+	looked(2,0) = 0.0;
+	looked(1,1) = 3.0;
+	read += looked(0,1);
+	std::ostringstream shown;
+	std::streambuf* out = std::cout.rdbuf(shown.rdbuf());
+	looked.display();
+	std::cout.rdbuf(out);
+	if(read!=0.0 || shown.str()!="\n1 1   3\n" || looked(1,1)!=3.0)
+	{ti->failItem(__SPOT__); return false;}
+    }
+
+    // elements of values not stored, held at the same time, are written
+    // each to its own value.
+    {
+	flopc::MP_sparse_data held(mySet,mySet);
+	flopc::DataElement a = held(0,1);
+	flopc::DataElement b = held(2,2);
+	flopc::DataElement c = held(0,0);
+	a = 10.0;
+	b = 20.0;
+	c += 5.0;
+	a *= 2.0;
+	if(held(0,1)!=20.0 || held(2,2)!=20.0 || held(0,0)!=5.0 ||
+	   b!=20.0 || held(1,1)!=0.0)
+	{ti->failItem(__SPOT__); return false;}
+    }
+
+    // sparse data over more elements than an int counts.
+    {
+	flopc::MP_set s1(2000), s2(500), s3(50), s4(12), s5(4);
+	flopc::MP_sparse_data huge(s1,s2,s3,s4,s5);
+	huge(1999,499,49,11,3) = 7.0;
+	if(huge.size()!=static_cast<CoinInt64>(2000)*500*50*12*4 ||
+	   huge(1999,499,49,11,3)!=7.0 || huge(0,0,0,0,0)!=0.0)
+	{ti->failItem(__SPOT__); return false;}
+    }
+
+    // assignments over a block: the same values whether computed as
+    // arrays or element by element, as with a condition.
+    flopc::MP_data blockData(mySet,mySet), walkData(mySet,mySet);
+    blockData(i,j) = myData(i)*2.0 + myData(j)/myData(i) -
+	flopc::Constant(j);
+    walkData(i,j).such_that(true) = myData(i)*2.0 + myData(j)/myData(i) -
+	flopc::Constant(j);
+    blockData(i,j) = blockData(i,j) + blockData(i,1);
+    walkData(i,j).such_that(true) = walkData(i,j) + walkData(i,1);
+    for(int a=0; a<3; a++) for(int b=0; b<3; b++)
+	if(blockData(a,b)!=walkData(a,b))
+	{ti->failItem(__SPOT__); return false;}
+
+    // index dependencies: known for index expressions and data, unknown
+    // for constants which loop over a set of their own.
+    std::set<const flopc::MP_index*> deps;
+    if((i+j)->insertIndices(deps)!=true || deps.size()!=2)
+    {ti->failItem(__SPOT__); return false;}
+    deps.clear();
+    if(flopc::Constant(myData(i))->insertIndices(deps)!=true ||
+       deps.count(&i)!=1 || deps.count(&j)!=0)
+    {ti->failItem(__SPOT__); return false;}
+    if((flopc::sum(mySet(i),flopc::abs(i+1)))->insertIndices(deps)!=false)
+    {ti->failItem(__SPOT__); return false;}
+
+    // data dependencies: only the data read count, and any change of it.
+    flopc::MP_data otherData(mySet);
+    flopc::DataDependencies reads;
+    {
+	flopc::DataReadRecorder recorder(&reads);
+	flopc::sum(mySet(i),myData(i))->evaluate();
+    }
+    if(reads.changed()!=false)
+    {ti->failItem(__SPOT__); return false;}
+    otherData(1) = 5.0;
+    if(reads.changed()!=false)
+    {ti->failItem(__SPOT__); return false;}
+    myData.value(d);
+    if(reads.changed()!=true)
+    {ti->failItem(__SPOT__); return false;}
+
+    // saved data are mapped back with the same values, whether dense or
+    // sparse; writes to the mapped values do not reach the file, and
+    // sets of other sizes are refused.
+    {
+	flopc::MP_set rows(3), cols(4);
+	flopc::MP_data dense(rows,cols);
+	flopc::MP_sparse_data sparse(rows,cols);
+	sparse.initialize(-2.0);
+	sparse(1,3) = 5.0;
+	sparse(2,0) = 0.0;
+	for (int r=0; r<3; r++) {
+	    for (int c=0; c<4; c++) {
+		dense(r,c) = 10*r+c;
+	    }
+	}
+	dense.save("constantTest.dense");
+	sparse.save("constantTest.sparse");
+	bool same = true;
+	{
+	    flopc::MP_mapped_data mappedDense("constantTest.dense",rows,cols);
+	    flopc::MP_mapped_data mappedSparse("constantTest.sparse",rows,cols);
+	    for (int r=0; r<3; r++) {
+		for (int c=0; c<4; c++) {
+		    same = same && mappedDense(r,c)==10*r+c &&
+			mappedSparse(r,c)==sparse(r,c);
+		}
+	    }
+	    mappedDense(0,0) = 99.0;
+	}
+	flopc::MP_mapped_data again("constantTest.dense",rows,cols);
+	bool refused = false;
+	try {
+	    flopc::MP_mapped_data wrong("constantTest.dense",cols,rows);
+	} catch (CoinError&) {
+	    refused = true;
+	}
+	std::remove("constantTest.dense");
+	std::remove("constantTest.sparse");
+	if(same==false || sparse(1,3)!=5.0 || sparse(2,0)!=0.0 || 
+	   sparse(0,0)!=-2.0 || again(0,0)!=0.0 || refused==false)
+	{ti->failItem(__SPOT__); return false;}
+    }
+
+    // loading delimited text: quotes, blanks, empty lines and a header
+    // are ignored, the delimiter is found from the first line, and rows
+    // which cannot be parsed or are outside the sets, even cyclic ones,
+    // are skipped.
+    {
+	std::FILE* f = std::fopen("constantTest.csv","w");
+	std::fputs("from,to,value\n\"a\", 0 , 1.5\nb,1,2.5\n\n \"c\" ,2,3\n"
+		   "a,3,4\nb,-1,5\nc,x,6\na,1\nc,0,7\n",f);
+	std::fclose(f);
+	f = std::fopen("constantTest.tsv","w");
+	std::fputs("a\t0\t1.5\nb\t1\t2.5\nc\t2\t3\nc\t0\t7\n",f);
+	std::fclose(f);
+	f = std::fopen("constantTest.sub","w");
+	std::fputs("0,1\n2,5\n1,2,ignored\n",f);
+	std::fclose(f);
+
+	flopc::MP_set from(3), to(3);
+	to.cyclic();
+	flopc::SymbolTable labels, tsvLabels;
+	flopc::MP_data csv(from,to), tsv(from,to);
+	flopc::DataLoader loader(1);
+	loader.setHeader(true);
+	loader.load("constantTest.csv",csv,&labels);
+	const int csvRows = loader.getRows(), csvSkipped = loader.getSkipped();
+	loader.setHeader(false);
+	loader.load("constantTest.tsv",tsv,&tsvLabels);
+	const int tsvRows = loader.getRows();
+	bool same = true;
+	for (int r=0; r<3; r++) {
+	    for (int c=0; c<3; c++) {
+		same = same && csv(r,c)==tsv(r,c);
+	    }
+	}
+	flopc::MP_subset<2> sub(to,to);
+	loader.load("constantTest.sub",sub);
+	std::remove("constantTest.csv");
+	std::remove("constantTest.tsv");
+	std::remove("constantTest.sub");
+	if(csvRows!=4 || csvSkipped!=4 || tsvRows!=4 || same==false ||
+	   labels.size()!=3 || labels.find("c")!=2 ||
+	   csv(0,0)!=1.5 || csv(1,1)!=2.5 || csv(2,2)!=3.0 || csv(2,0)!=7.0 ||
+	   csv(0,1)!=0.0 || csv(1,2)!=0.0)
+	{ti->failItem(__SPOT__); return false;}
+	if(loader.getRows()!=2 || loader.getSkipped()!=1 || sub.size()!=2 ||
+	   sub(0,1)==flopc::outOfBound || sub(1,2)==flopc::outOfBound)
+	{ti->failItem(__SPOT__); return false;}
+    }
+
+    // the result does not depend on the number of threads parsing.
+    {
+	std::FILE* f = std::fopen("constantTest.big","w");
+	for (int r=0; r<5000; r++) {
+	    std::fprintf(f,"n%d,%d,%d.25\n",(r*37)%101,r%7,r);
+	}
+	std::fclose(f);
+	flopc::MP_set nodes(101), days(7);
+	flopc::SymbolTable one, many;
+	flopc::MP_data byOne(nodes,days), byMany(nodes,days);
+	flopc::DataLoader serial(1), parallel(4);
+	serial.load("constantTest.big",byOne,&one);
+	parallel.load("constantTest.big",byMany,&many);
+	std::remove("constantTest.big");
+	bool same = (one.size()==101 && many.size()==101 &&
+		     serial.getRows()==5000 && parallel.getRows()==5000);
+	for (int n=0; same==true && n<101; n++) {
+	    same = one.label(n)==many.label(n);
+	    for (int d=0; d<7; d++) {
+		same = same && byOne(n,d)==byMany(n,d);
+	    }
+	}
+	if(same==false)
+	{ti->failItem(__SPOT__); return false;}
+    }
+
     ti->passItem();
     return true;
 }
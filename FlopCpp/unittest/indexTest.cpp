@@ -20,6 +20,17 @@ bool indexTest() {
     if(idx.evaluate()!=3)
     {ti->failItem(__SPOT__); return false;}
 
+    // bindings made in another evaluation context are not visible here.
+    {
+        EvaluationContext context;
+        ContextBinder binder(context);
+        if(idx.isInstantiated() || idx.evaluate()!=0)
+        {ti->failItem(__SPOT__); return false;}
+        idx.assign(7);
+    }
+    if(idx.evaluate()!=3)
+    {ti->failItem(__SPOT__); return false;}
+
     MP_index *pIdx = idx.getIndex();
     if(pIdx!=&idx)
     { ti->failItem(__SPOT__); return false;}
@@ -65,6 +76,32 @@ bool indexTest() {
     MP_index_exp ie8(idx);
     // construction of an index expression from an index.
     MP_index_exp ie9(ie8);
+
+    // index plus constant forms, as lowered by compiled generation.
+    const MP_index* affineIndex = 0;
+    int affineShift = 0;
+    if(ie2->getAffine(affineIndex,affineShift)!=true ||
+       affineIndex!=&idx || affineShift!=3)
+    {ti->failItem(__SPOT__);  return false;}
+    if(ie3->getAffine(affineIndex,affineShift)!=true ||
+       affineIndex!=&idx || affineShift!=-1)
+    {ti->failItem(__SPOT__);  return false;}
+    if(ie6->getAffine(affineIndex,affineShift)!=true ||
+       affineIndex!=0 || affineShift!=3)
+    {ti->failItem(__SPOT__);  return false;}
+    if(ie5->getAffine(affineIndex,affineShift)!=false)
+    {ti->failItem(__SPOT__);  return false;}
+    // an index made after one bound was destroyed, possibly in its
+    // place, starts out unbound.
+    for (int k=0; k<100; k++) {
+        MP_index* gone = new MP_index;
+        gone->instantiate();
+        gone->assign(k+1);
+        delete gone;
+        MP_index fresh;
+        if(fresh.isInstantiated()==true || fresh.evaluate()!=0)
+        {ti->failItem(__SPOT__);  return false;}
+    }
     ti->passItem();
     return true;
 }
@@ -1,8 +1,23 @@
+#include <algorithm>
 #include "MP_set.hpp"
+#include "MP_data.hpp"
+#include "MP_domain.hpp"
 #include "TestItem.hpp"
 
 using namespace flopc;
 
+// Records the values of two indices at each element of a domain walk.
+class WalkRecorder: public Functor {
+public:
+    WalkRecorder(const MP_index& a, const MP_index& b) : A(a), B(b) {}
+    void operator()() const {
+        walked.push_back(std::make_pair(A.evaluate(),B.evaluate()));
+    }
+    const MP_index& A;
+    const MP_index& B;
+    mutable std::vector<std::pair<int,int> > walked;
+};
+
 class MyBooleanTest: public MP_boolean {
 public:
     MyBooleanTest(MP_set &s)
@@ -49,6 +64,113 @@ bool setTest() {
     MP_set setFromEnum(ABCSIZE);
     if(setFromEnum.size()!=3)
     {ti->failItem(__SPOT__); return false; }
+
+    // subset elements matching an index bound outside, and after inserts.
+    MP_set I(4), J(5);
+    MP_subset<2> L(I,J);
+    L.insert(0,1); L.insert(0,3); L.insert(2,1); L.insert(3,4);
+    MP_index j;
+    MP_data count(I);
+    count(i) = sum(L(i,j),1);
+    if(count(0)!=2 || count(1)!=0 || count(2)!=1 || count(3)!=1)
+    {ti->failItem(__SPOT__); return false; }
+    L.insert(1,2); L.insert(0,0);
+    count(i) = sum(L(i,j),1);
+    if(count(0)!=3 || count(1)!=1 || count(2)!=1 || count(3)!=1)
+    {ti->failItem(__SPOT__); return false; }
+
+    // copies of a subset keep its elements but not its indexes, and
+    // change independently of it.
+    {
+        MP_subset<2> copy(L);
+        if(copy.size()!=L.size() || copy(1,2)!=L(1,2) || copy(1,3)!=outOfBound)
+        {ti->failItem(__SPOT__); return false; }
+        copy.insert(1,3);
+        count(i) = sum(copy(i,j),1);
+        if(L.size()!=6 || count(0)!=3 || count(1)!=2)
+        {ti->failItem(__SPOT__); return false; }
+        copy = L;
+        count(i) = sum(copy(i,j),1);
+        if(copy.size()!=6 || count(1)!=1)
+        {ti->failItem(__SPOT__); return false; }
+    }
+
+    // subset elements keep their numbers and values when a set they
+    // range over grows past the bases they are packed in, and when the
+    // keys would overflow and the values are stored instead.
+    {
+        MP_set P(100000);
+        MP_subset<1> G(P);
+        G.insert(0);
+        MP_subset<2> B(G,G);
+        MP_subset<5> F(G,G,G,G,G);
+        B.insert(0,0);
+        F.insert(0,0,0,0,0);
+        for (int g=1; g<10000; g++) {
+            G.insert(g);
+        }
+        B.insert(9999,3);
+        B.insert(5,9999);
+        F.insert(9999,1,9999,2,9999);
+        F.insert(9999,1,0,2,9999);
+        if(B.size()!=3 || B(0,0)!=0 || B(9999,3)!=1 || B(5,9999)!=2 ||
+           B(3,9999)!=outOfBound)
+        {ti->failItem(__SPOT__); return false; }
+        if(F.size()!=3 || F(0,0,0,0,0)!=0 || F(9999,1,9999,2,9999)!=1 ||
+           F(9999,1,0,2,9999)!=2 || F(9999,1,9999,2,0)!=outOfBound)
+        {ti->failItem(__SPOT__); return false; }
+        int t[5];
+        F.values(1,t);
+        if(t[0]!=9999 || t[1]!=1 || t[2]!=9999 || t[3]!=2 || t[4]!=9999)
+        {ti->failItem(__SPOT__); return false; }
+        const std::vector<int>& byValue = F.order();
+        if(byValue.size()!=3 || byValue[0]!=0 || byValue[1]!=2 || 
+           byValue[2]!=1)
+        {ti->failItem(__SPOT__); return false; }
+        MP_index a, b, c, d, e;
+        WalkRecorder walk(a,c);
+        MP_domain(F(a,b,c,d,e)).Forall(&walk);
+        if(walk.walked.size()!=3 || walk.walked[0]!=std::make_pair(0,0) ||
+           walk.walked[1]!=std::make_pair(9999,0) ||
+           walk.walked[2]!=std::make_pair(9999,9999))
+        {ti->failItem(__SPOT__); return false; }
+    }
+
+    // a product no order makes much cheaper is walked as written.
+    {
+        WalkRecorder written(i,j), planned(i,j);
+        MP_domain d = I(i)*J(j);
+        d.Forall(&written);
+        d.plan().Forall(&planned);
+        if(written.walked.size()!=4*5 || planned.walked!=written.walked)
+        {ti->failItem(__SPOT__); return false; }
+    }
+    // the small subset L drives the loop over j, which then only passes
+    // through; the planned walk visits the same elements, in the order
+    // of L, on every call.
+    {
+        MP_set K(50);
+        MP_subset<2> S(I,K);
+        S.insert(0,40); S.insert(2,40); S.insert(3,7);
+        MP_index k;
+        WalkRecorder written(k,i), planned(k,i), again(k,i);
+        MP_domain d = K(k)*S(i,k);
+        d.Forall(&written);
+        d.plan().Forall(&planned);
+        d.plan().Forall(&again);
+        if(written.walked.size()!=3 || planned.walked.size()!=3)
+        {ti->failItem(__SPOT__); return false; }
+        if(written.walked[0]!=std::make_pair(7,3) ||
+           planned.walked[0]!=std::make_pair(40,0) || 
+           planned.walked[1]!=std::make_pair(40,2) ||
+           planned.walked[2]!=std::make_pair(7,3))
+        {ti->failItem(__SPOT__); return false; }
+        std::vector<std::pair<int,int> > a(written.walked), b(planned.walked);
+        std::sort(a.begin(),a.end());
+        std::sort(b.begin(),b.end());
+        if(a!=b || again.walked!=planned.walked)
+        {ti->failItem(__SPOT__); return false; }
+    }
     ti->passItem();
     return true;
 }